@@ -0,0 +1,82 @@
+#ifndef BENCHCOMMON
+#define BENCHCOMMON
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Scaffolding shared by the benchmarks. Each one is a single translation unit, which is the only one to include this:
+// the counting operator new below replaces the global one for the whole executable.
+
+// Heap allocations made by the process so far.
+static std::atomic<std::size_t> allocations {0};
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// A long article page: navigation, sections of paragraphs with inline links, lists and a table per section.
+inline std::string syntheticPage(const std::size_t sections) {
+    std::ostringstream html;
+    html << "<html><head><title>bench</title></head><body><nav><ul>";
+    for (std::size_t i = 0; i < 40; ++i) html << "<li class=\"nav\"><a href=\"/nav/" << i << "\">Section " << i << "</a></li>";
+    html << "</ul></nav><main>";
+    for (std::size_t s = 0; s < sections; ++s) {
+        html << "<section id=\"s" << s << "\"><h2>Heading <span>" << s << "</span></h2>";
+        for (std::size_t p = 0; p < 4; ++p) {
+            html << "<p class=\"text\">Some <b>bold</b> text with <a href=\"/article/" << s << '/' << p
+                 << "\">a link</a> and <em>emphasis</em>.</p>";
+        }
+        html << "<ul>";
+        for (std::size_t li = 0; li < 3; ++li) html << "<li><a href=\"/item/" << s << '/' << li << "\">item</a></li>";
+        html << "</ul><table><tr><td>a</td><td>b</td></tr><tr><td>c</td><td>d</td></tr></table></section>";
+    }
+    html << "</main><footer><a href=\"/about\">About</a></footer></body></html>";
+    return html.str();
+}
+
+// Runs `fn` `rounds` times and prints the time and allocations per pass; `fn` returns a checksum so the work is kept.
+template<typename Fn>
+void measure(const char* label, const std::size_t rounds, Fn&& fn) {
+    std::size_t checksum = 0;
+    const std::size_t before = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t r = 0; r < rounds; ++r) checksum += fn();
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(rounds);
+    const double allocated = static_cast<double>(allocations.load() - before) / static_cast<double>(rounds);
+    std::cout << "  " << std::left << std::setw(30) << label << std::right << us << " us, " << allocated << " allocations per pass (checksum " << checksum / rounds << ")\n";
+}
+
+// Calls `bench(name, html)` for each HTML file named on the command line, or for a generated page if there are none.
+// Returns main's exit status.
+template<typename Bench>
+int benchPages(const int argc, char** argv, Bench&& bench) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            std::ifstream in(argv[i], std::ios::binary);
+            if (!in) {
+                std::cerr << "cannot read " << argv[i] << '\n';
+                return 1;
+            }
+            std::ostringstream html;
+            html << in.rdbuf();
+            bench(argv[i], html.str());
+        }
+        return 0;
+    }
+    bench("synthetic article", syntheticPage(500));
+    return 0;
+}
+
+#endif
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "../include/net/URLCanonicalizer.hpp"
+#include "../include/net/VisitedSet.hpp"
+
+template<typename Fn>
+double nsPerItem(const std::size_t items, const int rounds, Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) fn();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(items) * rounds);
+}
+
+int main() {
+    const std::vector<std::string> shapes = {
+        "http://Example.COM/articles/2023/item-",
+        "https://www.example.com:443/a/b/../c/./d/page-",
+        "http://news.example.org:80/section/index.html?b=2&a=1&utm_source=feed&id=",
+        "https://shop.example.net/catalog/%7euser/product?sku=",
+        "http://blog.example.io/post#comments-",
+    };
+
+    std::vector<std::string> urls;
+    constexpr std::size_t count = 200000;
+    urls.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) urls.emplace_back(shapes[i % shapes.size()] + std::to_string(i));
+
+    std::size_t sink = 0;
+    URLCanonicalizer plain;
+    const double base = nsPerItem(count, 10, [&]{
+        for (const auto& url : urls) sink += plain.canonicalize(url).size();
+    });
+
+    URLCanonicalizer filtered;
+    filtered.setSortQuery(true);
+    filtered.setStrippedParams({"utm_*", "fbclid", "gclid"});
+    const double query = nsPerItem(count, 10, [&]{
+        for (const auto& url : urls) sink += filtered.canonicalize(url).size();
+    });
+
+    const double hashed = nsPerItem(count, 10, [&]{
+        for (const auto& url : urls) sink += fingerprint64(plain.canonicalize(url)) & 1;
+    });
+
+    std::cout << "canonicalize:                 " << base << " ns/url\n";
+    std::cout << "canonicalize + query filters: " << query << " ns/url\n";
+    std::cout << "canonicalize + fingerprint:   " << hashed << " ns/url\n";
+    std::cout << "(checksum " << sink << ")\n";
+    return 0;
+}
\ No newline at end of file
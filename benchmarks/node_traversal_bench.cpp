@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/parser/Parser.hpp"
+#include "bench_common.hpp"
+
+// How Node worked before: three words per handle, and every step hands out a new heap object.
+struct LegacyNode {
+    lxb_dom_node_t* node;
+    lxb_html_document_t* document;
+    DomCollection& collection;
+
+    LegacyNode(lxb_dom_node_t* node, lxb_html_document_t* document, DomCollection& collection)
+        : node(node), document(document), collection(collection) {}
+
+    std::unique_ptr<LegacyNode> firstChild() const {
+        if (lxb_dom_node_is_empty(node)) return nullptr;
+        lxb_dom_node_t* child = Node::nextElement(lxb_dom_node_first_child(node));
+        return child ? std::make_unique<LegacyNode>(child, document, collection) : nullptr;
+    }
+
+    // The old nextSibling returned the node itself; this one steps forward so a walk terminates.
+    std::unique_ptr<LegacyNode> nextSibling() const {
+        lxb_dom_node_t* sibling = Node::nextElement(lxb_dom_node_next(node));
+        return sibling ? std::make_unique<LegacyNode>(sibling, document, collection) : nullptr;
+    }
+
+    const std::string getAttribute(const std::string& name) const {
+        return std::string(Node(node).attributeValue(name));
+    }
+
+    // getElementsByTagName into the shared collection, copied out the way NodeList used to, then item(i) for each
+    // result.
+    template<typename Fn>
+    void eachByTagName(const std::string& tag, Fn&& fn) const {
+        collection.clean();
+        lxb_dom_elements_by_tag_name(lxb_dom_interface_element(node), collection.get(),
+                                     reinterpret_cast<const lxb_char_t*>(tag.c_str()), tag.length());
+        const std::size_t length = lxb_dom_collection_length(collection.get());
+        auto list = std::make_unique<std::vector<lxb_dom_node_t*>>();
+        list->reserve(length);
+        for (std::size_t i = 0; i < length; ++i) {
+            lxb_dom_node_t* found = lxb_dom_collection_node(collection.get(), i);
+            if (!lxb_dom_node_is_empty(found)) list->emplace_back(found);
+        }
+        for (std::size_t i = 0; i < list->size(); ++i) fn(*std::make_unique<LegacyNode>((*list)[i], document, collection));
+    }
+};
+
+std::size_t legacyWalk(const LegacyNode& node) {
+    std::size_t count = 1;
+    for (auto child = node.firstChild(); child; child = child->nextSibling()) count += legacyWalk(*child);
+    return count;
+}
+
+std::size_t walk(const Node node) {
+    std::size_t count = 1;
+    for (const Node child : node.children()) count += walk(child);
+    return count;
+}
+
+void bench(const std::string& name, const std::string& html) {
+    Parser parser;
+    Document document = parser.createDOM(html);
+    const Node body = document.rootElement();
+    DomCollection collection(reinterpret_cast<lxb_html_document_t*>(body.get()->owner_document));
+    const LegacyNode legacy(body.get(), reinterpret_cast<lxb_html_document_t*>(body.get()->owner_document), collection);
+    const std::size_t elements = walk(body);
+    const std::size_t rounds = std::max<std::size_t>(1, 2000000 / elements);
+
+    std::cout << name << ": " << html.size() / 1024 << " KiB, " << elements << " elements\n";
+    std::cout << " tree walk\n";
+    measure("unique_ptr per step", rounds, [&]{ return legacyWalk(legacy); });
+    measure("Node::children()", rounds, [&]{ return walk(body); });
+
+    std::cout << " every element\n";
+    measure("by tag \"*\" + item(i)", rounds, [&]{
+        std::size_t count = 0;
+        legacy.eachByTagName("*", [&count](const LegacyNode&){ ++count; });
+        return count;
+    });
+    measure("Node::descendants()", rounds, [&]{
+        std::size_t count = 0;
+        for (const Node n : body.descendants()) count += n ? 1 : 0;
+        return count;
+    });
+
+    std::cout << " href of every <a>\n";
+    measure("by tag \"a\" + getAttribute", rounds, [&]{
+        std::size_t bytes = 0;
+        legacy.eachByTagName("a", [&bytes](const LegacyNode& a){ bytes += a.getAttribute("href").size(); });
+        return bytes;
+    });
+    measure("filtered descendants", rounds, [&]{
+        std::size_t bytes = 0;
+        for (const Node a : body.descendants().filter([](const Node n){ return n.tagName() == "a"; })) bytes += a.attributeValue("href").size();
+        return bytes;
+    });
+
+    std::cout << " nested: <a> under each <section>\n";
+    measure("copied out of the collection", rounds, [&]{
+        std::size_t count = 0;
+        legacy.eachByTagName("section", [&count](const LegacyNode& section){
+            section.eachByTagName("a", [&count](const LegacyNode&){ ++count; });
+        });
+        return count;
+    });
+    measure("NodeList per query", rounds, [&]{
+        std::size_t count = 0;
+        if (auto sections = body.getElementsByTagName("section")) {
+            for (const Node section : *sections) {
+                if (auto anchors = section.getElementsByTagName("a")) count += anchors->length();
+            }
+        }
+        return count;
+    });
+}
+
+int main(int argc, char** argv) {
+    return benchPages(argc, argv, bench);
+}
\ No newline at end of file
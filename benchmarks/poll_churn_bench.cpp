@@ -0,0 +1,105 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../include/async/EventLoop.hpp"
+#include "../include/async/PollWrapper.hpp"
+#include "../include/async/PollPool.hpp"
+#include "bench_common.hpp"
+
+struct Result {
+    double per_second;
+    double allocations;
+    std::size_t wrappers {0};
+};
+
+// Short-lived connections the way curl reports them: each socket is watched, delivers an event, and is removed
+// while `window` others stay open; its fd number is freed at once and comes straight back for the next socket.
+// `Watch` opens a watcher for an fd and `Unwatch` closes it.
+template<typename Watch, typename Unwatch>
+Result churn(EventLoop& loop, const std::size_t connections, const std::size_t window, Watch&& watch, Unwatch&& unwatch) {
+    // A ring of open socket pairs, so the harness itself allocates nothing while measuring.
+    std::vector<std::pair<int, int>> open(window);
+    std::size_t oldest = 0, count = 0;
+    auto connect = [&]{
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) throw std::runtime_error("socketpair failed");
+        watch(pair[0]);
+        open[(oldest + count++) % window] = {pair[0], pair[1]};
+    };
+    auto disconnect = [&]{
+        const auto [fd, peer] = open[oldest];
+        oldest = (oldest + 1) % window;
+        --count;
+        unwatch(fd);
+        ::close(fd);
+        ::close(peer);
+    };
+
+    // Warm up, so the comparison is of steady state rather than first use.
+    for (std::size_t i = 0; i < window; ++i) connect();
+    loop.run(UV_RUN_NOWAIT);
+
+    const std::size_t before = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < connections; ++i) {
+        disconnect();
+        connect();
+        loop.run(UV_RUN_NOWAIT);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::size_t allocated = allocations.load() - before;
+
+    while (count) disconnect();
+    loop.run(UV_RUN_NOWAIT);
+    return {static_cast<double>(connections) / seconds, static_cast<double>(allocated) / static_cast<double>(connections)};
+}
+
+// What socket_function did before the pool: a new wrapper per socket, deleted from its close callback.
+Result perSocket(const std::size_t connections, const std::size_t window) {
+    EventLoop loop(LoopType::Private);
+    std::vector<PollWrapper*> by_fd;
+    std::size_t events = 0;
+    const Result r = churn(loop, connections, window,
+        [&](const int fd){
+            auto* poll = new PollWrapper(loop, fd);
+            poll->on<PollEvent, PollWrapper>([&events](const PollEvent&, PollWrapper&){ ++events; });
+            poll->start(UV_WRITABLE);
+            if (static_cast<std::size_t>(fd) >= by_fd.size()) by_fd.resize(static_cast<std::size_t>(fd) + 1);
+            by_fd[fd] = poll;
+        },
+        [&](const int fd){
+            by_fd[fd]->close([](PollWrapper* poll){ delete poll; });
+            by_fd[fd] = nullptr;
+        });
+    loop.run();
+    return r;
+}
+
+Result pooled(const std::size_t connections, const std::size_t window) {
+    EventLoop loop(LoopType::Private);
+    PollPool pool(loop);
+    std::size_t events = 0;
+    pool.on([&events](const PollEvent&, PollWrapper&){ ++events; });
+    Result r = churn(loop, connections, window,
+        [&](const int fd){ pool.acquire(fd)->start(UV_WRITABLE); },
+        [&](const int fd){ pool.release(fd); });
+    pool.close();
+    loop.run();
+    r.wrappers = pool.capacity();
+    return r;
+}
+
+int main() {
+    constexpr std::size_t connections = 200000;
+    for (const std::size_t window : {8, 256}) {
+        const Result a = perSocket(connections, window);
+        const Result b = pooled(connections, window);
+        std::cout << connections << " connections, " << window << " open at a time\n";
+        std::cout << "  new/delete per socket  " << a.per_second / 1e3 << " k conn/s, " << a.allocations << " allocations per connection\n";
+        std::cout << "  PollPool               " << b.per_second / 1e3 << " k conn/s, " << b.allocations << " allocations per connection, " << b.wrappers << " wrappers in all\n";
+    }
+    return 0;
+}
\ No newline at end of file
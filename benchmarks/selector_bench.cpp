@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+
+#include "../include/parser/Parser.hpp"
+#include "bench_common.hpp"
+
+std::size_t count(const std::unique_ptr<NodeList>& list) {
+    return list ? list->length() : 0;
+}
+
+void bench(const std::string& name, const std::string& html) {
+    Parser parser;
+    Document document = parser.createDOM(html);
+    const Node body = document.rootElement();
+    std::size_t elements = 0;
+    for (const Node n : body.descendants()) elements += n ? 1 : 0;
+    const std::size_t rounds = std::max<std::size_t>(1, 2000000 / std::max<std::size_t>(1, elements));
+
+    std::cout << name << ": " << html.size() / 1024 << " KiB, " << elements << " elements\n";
+
+    std::cout << " section p.text a\n";
+    measure("chained getElementsBy*", rounds, [&]{
+        std::size_t found = 0;
+        if (auto sections = body.getElementsByTagName("section")) {
+            for (const Node section : *sections) {
+                auto texts = section.getElementsByClassName("text");
+                if (!texts) continue;
+                for (const Node p : *texts) {
+                    if (p.tagName() == "p") found += count(p.getElementsByTagName("a"));
+                }
+            }
+        }
+        return found;
+    });
+    measure("querySelectorAll", rounds, [&]{ return count(body.querySelectorAll("section p.text a")); });
+
+    std::cout << " ul > li > a[href]\n";
+    measure("chained getElementsBy*", rounds, [&]{
+        std::size_t found = 0;
+        if (auto lists = body.getElementsByTagName("ul")) {
+            for (const Node ul : *lists) {
+                for (const Node li : ul.children()) {
+                    if (li.tagName() != "li") continue;
+                    for (const Node a : li.children()) found += a.tagName() == "a" && a.hasAttribute("href") ? 1 : 0;
+                }
+            }
+        }
+        return found;
+    });
+    measure("querySelectorAll", rounds, [&]{ return count(body.querySelectorAll("ul > li > a[href]")); });
+
+    std::cout << " #s42 td\n";
+    measure("chained getElementsBy*", rounds, [&]{
+        std::size_t found = 0;
+        if (auto sections = body.getElementsByAttribute("id", "s42")) {
+            for (const Node section : *sections) found += count(section.getElementsByTagName("td"));
+        }
+        return found;
+    });
+    measure("querySelectorAll", rounds, [&]{ return count(body.querySelectorAll("#s42 td")); });
+
+    std::cout << " first <a> in main\n";
+    measure("getElementsByTagName + item(0)", rounds, [&]{
+        std::size_t found = 0;
+        if (auto mains = body.getElementsByTagName("main")) {
+            if (auto anchors = mains->item(0).getElementsByTagName("a")) found += anchors->item(0).attributeValue("href").size();
+        }
+        return found;
+    });
+    measure("querySelector", rounds, [&]{ return body.querySelector("main a").attributeValue("href").size(); });
+
+    std::cout << " compiling \"section p.text a, ul > li > a[href]\"\n";
+    const std::string selectors = "section p.text a, ul > li > a[href]";
+    measure("parsed every call", rounds, [&]{
+        std::size_t found = 0;
+        SelectorCache::find(body.get(), SelectorCache::compile(selectors), [&found](lxb_dom_node_t*){
+            ++found;
+            return LXB_STATUS_OK;
+        });
+        return found;
+    });
+    measure("SelectorCache::global()", rounds, [&]{
+        std::size_t found = 0;
+        SelectorCache::find(body.get(), SelectorCache::global().get(selectors), [&found](lxb_dom_node_t*){
+            ++found;
+            return LXB_STATUS_OK;
+        });
+        return found;
+    });
+}
+
+int main(int argc, char** argv) {
+    return benchPages(argc, argv, bench);
+}
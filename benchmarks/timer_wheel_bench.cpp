@@ -0,0 +1,251 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <random>
+#include <thread>
+#include <string>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+
+#include "../include/net/TimerWheel.hpp"
+#include "../include/net/DaryHeap.hpp"
+#include "../include/net/URLRequestManager.hpp"
+#include "../include/async/EventLoop.hpp"
+#include "../include/async/TimerWrapper.hpp"
+
+// Any number of one-shot callbacks on a single uv timer: deadlines sit in a TimerWheel and the timer is only
+// ever armed for the earliest. This is how Async drives the frontier's wheels through its ready timer, reduced to
+// the timer alone so it can be set against one TimerWrapper per deadline.
+class WheelTimer {
+public:
+    using Callback = std::function<void()>;
+    using Id = TimerWheel<Callback>::Id;
+
+    explicit WheelTimer(const EventLoop& loop) : loop(loop), timer(loop), wheel(loop.now()) {
+        timer.on<TimerEvent, TimerWrapper>([self = this](const TimerEvent&, TimerWrapper&){
+            self->fire();
+        });
+    }
+
+    WheelTimer(const WheelTimer&) = delete;
+    WheelTimer& operator=(const WheelTimer&) = delete;
+
+    // Runs `fn` on the loop after `delay_ms`, measured from the loop's current time like a uv timer.
+    Id schedule(const uint64_t delay_ms, Callback fn) {
+        const Id id = wheel.insert(loop.now() + delay_ms, std::move(fn));
+        arm();
+        return id;
+    }
+
+    // False if the callback already ran or was cancelled. The uv timer may still wake up once for nothing.
+    const bool cancel(const Id id) {
+        const bool cancelled = wheel.cancel(id);
+        if (wheel.empty() && timer.isActive()) timer.stop();
+        return cancelled;
+    }
+
+    inline const std::size_t size() const noexcept { return wheel.size(); }
+
+    void close() noexcept {
+        timer.close();
+    }
+
+private:
+    const EventLoop& loop;
+    TimerWrapper timer;
+    TimerWheel<Callback> wheel;
+    uint64_t armed {0};
+
+    void arm() {
+        const int64_t wait = wheel.msUntilNext(loop.now());
+        if (wait < 0) return;
+        const uint64_t due = loop.now() + static_cast<uint64_t>(wait);
+        if (timer.isActive() && armed <= due) return;
+        armed = due;
+        timer.start(static_cast<uint64_t>(wait), 0);
+    }
+
+    void fire() {
+        wheel.advance(loop.now(), [](Callback&& fn){ fn(); });
+        arm();
+    }
+};
+
+template<typename Fn>
+double nsPerItem(const std::size_t items, Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(items);
+}
+
+struct Deadline {
+    uint64_t due;
+    std::size_t value;
+};
+
+struct DueFirst {
+    bool operator()(const Deadline& a, const Deadline& b) const noexcept { return a.due < b.due; }
+};
+
+// The data structures alone: a million deadlines up to a minute out, then time runs forward a millisecond at a time.
+void structures() {
+    constexpr std::size_t count = 1000000;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> delays(count);
+    for (auto& d : delays) d = rng() % 60000;
+    std::size_t sink = 0;
+
+    TimerWheel<std::size_t> wheel(0);
+    std::vector<TimerWheel<std::size_t>::Id> ids(count);
+    const double wheel_insert = nsPerItem(count, [&]{
+        for (std::size_t i = 0; i < count; ++i) ids[i] = wheel.insert(delays[i], i);
+    });
+    const double wheel_fire = nsPerItem(count, [&]{
+        for (uint64_t t = 1; t <= 60000; ++t) wheel.advance(t, [&](std::size_t&& v){ sink += v; });
+    });
+    for (std::size_t i = 0; i < count; ++i) ids[i] = wheel.insert(60000 + delays[i], i);
+    const double wheel_cancel = nsPerItem(count, [&]{
+        for (const auto id : ids) sink += wheel.cancel(id);
+    });
+
+    DaryHeap<Deadline, DueFirst> heap;
+    const double heap_insert = nsPerItem(count, [&]{
+        for (std::size_t i = 0; i < count; ++i) heap.push(Deadline{delays[i], i});
+    });
+    const double heap_fire = nsPerItem(count, [&]{
+        for (uint64_t t = 1; t <= 60000; ++t) {
+            while (!heap.empty() && heap.top().due <= t) sink += heap.pop().value;
+        }
+    });
+
+    std::cout << "1M deadlines over 60 s, advanced 1 ms at a time\n";
+    std::cout << "  TimerWheel  insert " << wheel_insert << " ns, fire " << wheel_fire << " ns, cancel " << wheel_cancel << " ns per timer\n";
+    std::cout << "  4-ary heap  insert " << heap_insert << " ns, fire " << heap_fire << " ns per timer (no cancel)\n";
+    std::cout << "  (checksum " << sink << ")\n";
+}
+
+// On a libuv loop: one TimerWrapper per deadline against one WheelTimer for all of them. Each variant schedules
+// `count` deadlines up to 50 ms out, cancels every other one, and runs the loop until the rest have fired.
+void loops(const std::size_t count) {
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> delays(count);
+    for (auto& d : delays) d = rng() % 50;
+
+    double per_handle_schedule, per_handle_total, wheel_schedule, wheel_total;
+    std::size_t fired = 0, per_handle_fired, wheel_fired;
+    {
+        EventLoop loop(LoopType::Private);
+        std::vector<std::unique_ptr<TimerWrapper>> timers;
+        timers.reserve(count);
+        const auto start = std::chrono::steady_clock::now();
+        per_handle_schedule = nsPerItem(count, [&]{
+            for (std::size_t i = 0; i < count; ++i) {
+                timers.emplace_back(std::make_unique<TimerWrapper>(loop));
+                timers.back()->on<TimerEvent, TimerWrapper>([&fired](const TimerEvent&, TimerWrapper&){ ++fired; });
+                timers.back()->start(delays[i], 0);
+            }
+            for (std::size_t i = 0; i < count; i += 2) timers[i]->stop();
+        });
+        loop.run();
+        for (auto& timer : timers) timer->close();
+        loop.run();
+        per_handle_total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        per_handle_fired = fired;
+        fired = 0;
+    }
+    {
+        EventLoop loop(LoopType::Private);
+        WheelTimer wheel(loop);
+        std::vector<WheelTimer::Id> ids(count);
+        const auto start = std::chrono::steady_clock::now();
+        wheel_schedule = nsPerItem(count, [&]{
+            for (std::size_t i = 0; i < count; ++i) ids[i] = wheel.schedule(delays[i], [&fired]{ ++fired; });
+            for (std::size_t i = 0; i < count; i += 2) wheel.cancel(ids[i]);
+        });
+        loop.run();
+        wheel.close();
+        loop.run();
+        wheel_total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        wheel_fired = fired;
+    }
+
+    std::cout << count << " deadlines on a uv loop, half cancelled\n";
+    std::cout << "  TimerWrapper each  schedule+cancel " << per_handle_schedule << " ns per timer, " << per_handle_total << " ms in all, " << per_handle_fired << " fired\n";
+    std::cout << "  one WheelTimer     schedule+cancel " << wheel_schedule << " ns per timer, " << wheel_total << " ms in all, " << wheel_fired << " fired\n";
+}
+
+// The path the crawler runs: failed requests go back through URLRequestManager::retry, and the loop sleeps for
+// msUntilReady() and pops whatever hasReadyURLs() lets through, as Async::processURLs does from its ready timer.
+// Backoffs are spread over seconds, far longer than the work itself, so the wheel decides when things run.
+// Lateness is how long after its deadline a retry's wakeup came.
+void frontier(const std::size_t count) {
+    constexpr uint64_t window_ms = 5000;
+    URLRequestManager manager;
+    std::mt19937_64 rng(11);
+    for (std::size_t i = 0; i < count; ++i) {
+        manager.addURL("http://host" + std::to_string(i % 1000) + ".example/page" + std::to_string(i));
+    }
+    std::vector<std::pair<Request, URLRequestManager::Key>> flying;
+    flying.reserve(count);
+    URLRequestManager::Key key;
+    while (manager.hasReadyURLs()) {
+        Request request = manager.popURL(&key);
+        flying.emplace_back(std::move(request), key);
+    }
+    // A second's head start, so every retry is queued before the first one falls due.
+    std::vector<uint64_t> delays(flying.size());
+    for (auto& d : delays) d = 1000 + rng() % window_ms;
+
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> due;
+    due.reserve(count);
+    for (std::size_t i = 0; i < flying.size(); ++i) due.emplace(flying[i].first.url, std::chrono::steady_clock::time_point());
+    const double retry = nsPerItem(count, [&]{
+        for (std::size_t i = 0; i < flying.size(); ++i) {
+            auto& [request, k] = flying[i];
+            due[request.url] = std::chrono::steady_clock::now() + std::chrono::milliseconds(delays[i]);
+            manager.retry(std::move(request), k, delays[i]);
+            manager.markDone();
+        }
+    });
+
+    std::size_t fired = 0, wakeups = 0;
+    double late_ms = 0, max_late_ms = 0, busy_ns = 0;
+    std::vector<std::string> popped;
+    popped.reserve(count);
+    while (fired < count) {
+        const long wait = manager.msUntilReady();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+        ++wakeups;
+        const auto woke = std::chrono::steady_clock::now();
+        popped.clear();
+        while (manager.hasReadyURLs()) {
+            Request request = manager.popURL();
+            manager.releaseHost(request.url);
+            manager.markDone();
+            popped.emplace_back(std::move(request.url));
+        }
+        busy_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - woke).count();
+        for (const auto& url : popped) {
+            const double late = std::chrono::duration<double, std::milli>(woke - due[url]).count();
+            late_ms += late;
+            max_late_ms = std::max(max_late_ms, late);
+        }
+        fired += popped.size();
+    }
+
+    std::cout << count << " retries over 1000 hosts, backoffs of 1 to " << 1 + window_ms / 1000 << " s, through URLRequestManager\n";
+    std::cout << "  retry " << retry << " ns, promote+pop " << busy_ns / static_cast<double>(count) << " ns per request, "
+              << wakeups << " wakeups, woken " << late_ms / static_cast<double>(count) << " ms late on average, "
+              << max_late_ms << " ms at most\n";
+}
+
+int main() {
+    structures();
+    loops(100000);
+    frontier(100000);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include <iostream>
+#include "../src/ShardedAsync.hpp"
+
+
+int sharded_example() {
+
+    constexpr int concurrent_connections = 200 , max_host_connections = 10 ;
+    ShardedAsync scraper(std::thread::hardware_concurrency() , concurrent_connections , max_host_connections);
+
+    scraper.configure([](Async& shard){
+        shard.setUserAgent("Scraper/ 1.1");
+        shard.setMultiplexing(true);
+        shard.setHttpVersion(HTTP::HTTP2);
+
+        shard.onSuccess([](const CurlEasyHandle::Response& response, Async& instance , Document& page){
+            auto links = page.rootElement()->getLinksMatching("https://.*");
+            for(const auto& link : *links) instance.addURL(link , response.depth + 1);
+        });
+
+        shard.onException([](const std::exception& e , Async& instance) {
+            std::cerr << "Exception encountered: " << e.what() << std::endl;    
+        });
+    });
+
+    scraper.seed("https://www.google.com/");
+    scraper.run();
+
+    std::cout << "Visited " << scraper.visitedUrlsSize() << " urls\n";
+    return 0;
+}
\ No newline at end of file
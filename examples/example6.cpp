@@ -0,0 +1,28 @@
+#include <iostream>
+#include "../src/HBscraper.hpp"
+
+
+int extractor_example() {
+
+    constexpr int concurrent_connections = 200 , max_host_connections = 10 ;
+    Async scraper(concurrent_connections , max_host_connections);
+
+    scraper.setUserAgent("Scraper/ 1.1");
+    scraper.addExtractor(std::make_unique<TitleExtractor>());
+    scraper.addExtractor(std::make_unique<LinkRelExtractor>("canonical"));
+    scraper.addExtractor(std::make_unique<MetaExtractor>("description"));
+
+    scraper.onExtracted([](const CurlEasyHandle::Response& response, Async& instance , const ExtractorSet& found){
+        const std::string* title = found.get("title");
+        const std::string* canonical = found.get("canonical");
+        std::cout << response.url << '\n'
+                  << "  title: " << (title ? *title : "-") << '\n'
+                  << "  canonical: " << (canonical ? *canonical : "-") << '\n'
+                  << "  read: " << response.bytesRecieved << " bytes\n";
+    });
+
+    scraper.seed("https://www.wikipedia.org/");
+    scraper.addURL("https://www.mozilla.org/", 0);
+    scraper.run();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef ASYNCW
+#define ASYNCW
+
+#include <uv.h>
+#include "HandleWrapperBase.hpp"
+#include <functional>
+#include "EventLoop.hpp"
+
+class AsyncWrapper final : public HandleWrapperBase {
+
+public:
+    explicit AsyncWrapper(const EventLoop& loop) noexcept {
+        check_uv_error(uv_async_init(loop.getLoop(), &async_handle, uv_async_callback));
+        async_handle.data = this;
+    }
+
+    ~AsyncWrapper() noexcept override {
+        close();
+    }
+
+    void close(std::function<void(AsyncWrapper*)> closeCb = nullptr) noexcept {
+        if (!isClosing()) {
+            close_callback = closeCb;  
+            uv_close(reinterpret_cast<uv_handle_t*>(&async_handle), uv_close_callback);
+        }
+    }
+
+    // The only call that is safe from another thread.
+    void send() noexcept {
+        check_uv_error(uv_async_send(&async_handle));
+    }
+
+    void ref() noexcept { uv_ref(reinterpret_cast<uv_handle_t*>(&async_handle)); }
+    void unref() noexcept { uv_unref(reinterpret_cast<uv_handle_t*>(&async_handle)); }
+
+    const bool isActive() const noexcept override {
+        return uv_is_active(reinterpret_cast<const uv_handle_t*>(&async_handle));
+    }
+
+    const bool isClosing() const noexcept override {
+        return uv_is_closing(reinterpret_cast<const uv_handle_t*>(&async_handle));
+    }
+
+private:
+    uv_async_t async_handle{};
+    std::function<void(AsyncWrapper*)> close_callback{};
+
+    static void uv_async_callback(uv_async_t* handle) noexcept {
+        auto* self = static_cast<AsyncWrapper*>(handle->data);
+        AsyncEvent event;
+        self->emit(event);
+    }
+
+    static void uv_close_callback(uv_handle_t* handle) noexcept {
+        auto* self = static_cast<AsyncWrapper*>(handle->data);
+        if (self->close_callback) {
+            self->close_callback(self);
+        }
+    }
+};
+
+#endif
\ No newline at end of file
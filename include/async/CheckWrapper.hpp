@@ -48,12 +48,11 @@ private:
     static void uv_check_callback(uv_check_t* handle) noexcept {
         auto* self = static_cast<CheckWrapper*>(handle->data);
         CheckEvent event;
-        EventDispatcher::getInstance().dispatch(event, *self);
+        self->emit(event);
     }
 
     static void uv_close_callback(uv_handle_t* handle) noexcept {
         auto* self = static_cast<CheckWrapper*>(handle->data);
-        EventDispatcher::getInstance().remove(self);
         if (self->close_callback) {
             self->close_callback(self);
         }
@@ -10,6 +10,7 @@ class IdleEvent final : public Event {};
 class TimerEvent final : public Event {};
 class CheckEvent final : public Event {};
 class PrepareEvent final : public Event {};
+class AsyncEvent final : public Event {};
 class PollEvent final : public Event {
 public:
     int status{};
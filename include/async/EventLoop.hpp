@@ -2,9 +2,17 @@
 #define EVENTL
 
 #include <uv.h>
+#include <memory>
+#include <stdexcept>
+
+enum class LoopType {
+    Default,
+    Private
+};
 
 class EventLoop {
     private:
+    std::unique_ptr<uv_loop_t> owned_loop;
     uv_loop_t* loop;
 public:
     EventLoop() noexcept {
@@ -13,9 +21,22 @@ public:
 
     explicit EventLoop(uv_loop_t* custom_loop) noexcept : loop(custom_loop) {}
 
+    explicit EventLoop(const LoopType type) {
+        if (type == LoopType::Default) {
+            loop = uv_default_loop();
+            return;
+        }
+        owned_loop = std::make_unique<uv_loop_t>();
+        loop = owned_loop.get();
+        if (uv_loop_init(loop) != 0) {
+            throw std::runtime_error("Failed to initialize event loop");
+        }
+    }
+
     ~EventLoop() noexcept {
         if (int result = uv_loop_close(loop); result == UV_EBUSY) {
             uv_walk(loop, on_uv_walk, nullptr);
+            if (owned_loop) uv_run(loop, UV_RUN_NOWAIT);
             uv_loop_close(loop);
         }
     }
@@ -24,6 +45,10 @@ public:
         return loop;
     }
 
+    inline const bool ownsLoop() const noexcept {
+        return owned_loop != nullptr;
+    }
+
     inline void run(uv_run_mode mode = UV_RUN_DEFAULT) noexcept {
         uv_run(loop, mode);
     }
@@ -64,7 +89,7 @@ public:
 private:
 
     static inline void on_uv_walk(uv_handle_t* handle, void* arg) noexcept {
-        uv_close(handle, on_uv_close);
+        if (!uv_is_closing(handle)) uv_close(handle, on_uv_close);
     }
 
     static inline void on_uv_close(uv_handle_t* handle) noexcept {
@@ -0,0 +1,61 @@
+#ifndef GETADDRW
+#define GETADDRW
+
+#include <uv.h>
+#include <string>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include "EventLoop.hpp"
+
+// One uv_getaddrinfo lookup at a time, resolved on libuv's thread pool; `done` runs on the loop thread with
+// the status (0, a UV_EAI_* error, or UV_ECANCELED) and the results, which are freed once it returns.
+class GetAddrInfoWrapper {
+public:
+    using Done = std::function<void(int status, const struct addrinfo* results)>;
+
+    explicit GetAddrInfoWrapper(const EventLoop& loop) noexcept : loop(loop.getLoop()) {
+        req.data = this;
+    }
+
+    GetAddrInfoWrapper(const GetAddrInfoWrapper&) = delete;
+    GetAddrInfoWrapper& operator=(const GetAddrInfoWrapper&) = delete;
+
+    void resolve(const std::string& node, Done after, const int family = AF_UNSPEC) {
+        if (busy) throw std::logic_error("A lookup is already running on this request");
+        host = node;
+        done = std::move(after);
+        struct addrinfo hints {};
+        hints.ai_family = family;
+        hints.ai_socktype = SOCK_STREAM;
+        if (const int ret = uv_getaddrinfo(loop, &req, uv_getaddrinfo_callback, host.c_str(), nullptr, &hints); ret != 0) {
+            throw std::runtime_error(uv_strerror(ret));
+        }
+        busy = true;
+    }
+
+    // Only succeeds while the lookup is still waiting for a pool thread.
+    const bool cancel() noexcept {
+        return busy && uv_cancel(reinterpret_cast<uv_req_t*>(&req)) == 0;
+    }
+
+    inline const bool isBusy() const noexcept { return busy; }
+    inline const std::string& getHost() const noexcept { return host; }
+
+private:
+    uv_loop_t* loop;
+    uv_getaddrinfo_t req{};
+    std::string host;
+    Done done;
+    bool busy {false};
+
+    static void uv_getaddrinfo_callback(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
+        auto* self = static_cast<GetAddrInfoWrapper*>(req->data);
+        self->busy = false;
+        std::unique_ptr<struct addrinfo, decltype(&uv_freeaddrinfo)> results(res, &uv_freeaddrinfo);
+        Done after = std::move(self->done);
+        if (after) after(status, results.get());
+    }
+};
+
+#endif
\ No newline at end of file
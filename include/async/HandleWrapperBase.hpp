@@ -1,31 +1,40 @@
 #ifndef HANDLEW
 #define HANDLEW
 
-#include "EventDispatcher.hpp"
+#include "Event.hpp"
+#include "InlineCallback.hpp"
 #include <uv.h>
 #include <stdexcept>
 
 class HandleWrapperBase {
 
 protected:
+    using Callback = InlineCallback<void(const Event&, HandleWrapperBase&)>;
+
     static inline void check_uv_error(const int ret) { if (ret != 0) throw std::runtime_error(uv_strerror(ret)); }
 
+    // Each wrapper keeps its own callback, so an event costs one indirect call and loops on different threads
+    // share nothing.
+    inline void emit(const Event& event) noexcept {
+        if (callback) callback(event, *this);
+    }
+
 public:
 
-    virtual ~HandleWrapperBase() noexcept {
-        EventDispatcher::getInstance().remove(this);
-    }
+    virtual ~HandleWrapperBase() noexcept = default;
 
     virtual const bool isActive() const noexcept = 0;
     virtual const bool isClosing() const noexcept = 0;
 
     template<typename EventType, typename DerivedType, typename Callback>
     void on(Callback&& callback) noexcept {
-        auto adapter = [callback = std::forward<Callback>(callback)] (const Event& event, HandleWrapperBase& handle) noexcept {
+        this->callback = [callback = std::forward<Callback>(callback)] (const Event& event, HandleWrapperBase& handle) noexcept {
             callback(static_cast<const EventType&>(event), static_cast<DerivedType&>(handle));
         };
-        EventDispatcher::getInstance().on(this, adapter);
     }
+
+private:
+    Callback callback;
 };
 
 #endif
\ No newline at end of file
@@ -37,12 +37,11 @@ private:
     static void uv_idle_callback(uv_idle_t* handle) noexcept {
         auto* self = static_cast<IdleWrapper*>(handle->data);
         IdleEvent event;
-        EventDispatcher::getInstance().dispatch(event, *self);
+        self->emit(event);
     }
 
     static void uv_close_callback(uv_handle_t* handle) noexcept {
         auto* self = static_cast<IdleWrapper*>(handle->data);
-        EventDispatcher::getInstance().remove(self);
         if (self->close_callback) {
             self->close_callback(self);
         }
@@ -0,0 +1,118 @@
+#ifndef INLINECB
+#define INLINECB
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+template<typename Signature, std::size_t Capacity = 48>
+class InlineCallback;
+
+// A move-only, type-erased callable kept inside the object: callables of up to `Capacity` bytes are stored in
+// place and called through one function pointer, larger ones are boxed on the heap. The handle wrappers keep
+// their callback in one of these, so dispatching an event needs no lookup and no allocation.
+template<typename R, typename... Args, std::size_t Capacity>
+class InlineCallback<R(Args...), Capacity> {
+    enum class Op { Move, Destroy };
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    R (*invoke_)(void*, Args&&...) {nullptr};
+    void (*manage_)(Op, void*, void*) {nullptr};
+
+    template<typename F>
+    static constexpr bool fits = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+                                 std::is_nothrow_move_constructible<F>::value;
+
+    template<typename F>
+    static F* target(void* p) noexcept {
+        if constexpr (fits<F>) return std::launder(static_cast<F*>(p));
+        else return *static_cast<F**>(p);
+    }
+
+    template<typename F>
+    static R call(void* p, Args&&... args) {
+        return (*target<F>(p))(std::forward<Args>(args)...);
+    }
+
+    template<typename F>
+    static void manage(const Op op, void* dst, void* src) noexcept {
+        if constexpr (fits<F>) {
+            if (op == Op::Move) {
+                ::new (dst) F(std::move(*target<F>(src)));
+                target<F>(src)->~F();
+            } else {
+                target<F>(dst)->~F();
+            }
+        } else {
+            if (op == Op::Move) *static_cast<F**>(dst) = *static_cast<F**>(src);
+            else delete *static_cast<F**>(dst);
+        }
+    }
+
+    template<typename F>
+    void assign(F&& fn) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fits<Fn>) ::new (static_cast<void*>(storage)) Fn(std::forward<F>(fn));
+        else *reinterpret_cast<Fn**>(storage) = new Fn(std::forward<F>(fn));
+        invoke_ = &call<Fn>;
+        manage_ = &manage<Fn>;
+    }
+
+    void reset() noexcept {
+        if (manage_) manage_(Op::Destroy, storage, nullptr);
+        invoke_ = nullptr;
+        manage_ = nullptr;
+    }
+
+    void take(InlineCallback& other) noexcept {
+        if (!other.manage_) return;
+        other.manage_(Op::Move, storage, other.storage);
+        invoke_ = other.invoke_;
+        manage_ = other.manage_;
+        other.invoke_ = nullptr;
+        other.manage_ = nullptr;
+    }
+
+public:
+    InlineCallback() noexcept = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineCallback>::value>>
+    InlineCallback(F&& fn) {
+        assign(std::forward<F>(fn));
+    }
+
+    InlineCallback(InlineCallback&& other) noexcept {
+        take(other);
+    }
+
+    InlineCallback& operator=(InlineCallback&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineCallback>::value>>
+    InlineCallback& operator=(F&& fn) {
+        reset();
+        assign(std::forward<F>(fn));
+        return *this;
+    }
+
+    InlineCallback(const InlineCallback&) = delete;
+    InlineCallback& operator=(const InlineCallback&) = delete;
+
+    ~InlineCallback() noexcept {
+        reset();
+    }
+
+    explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+    R operator()(Args... args) const {
+        return invoke_(const_cast<unsigned char*>(storage), std::forward<Args>(args)...);
+    }
+};
+
+#endif
\ No newline at end of file
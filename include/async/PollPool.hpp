@@ -0,0 +1,91 @@
+#ifndef POLLPOOL
+#define POLLPOOL
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <curl/curl.h>
+#include "EventLoop.hpp"
+#include "PollWrapper.hpp"
+
+// Poll wrappers for one loop, recycled: a wrapper whose close has completed goes on a free list and is opened
+// again for the next socket instead of being deleted, so steady connection churn allocates nothing. Open
+// wrappers are indexed by fd. All of them report to the one handler given to on().
+class PollPool {
+public:
+    using Handler = std::function<void(const PollEvent&, PollWrapper&)>;
+
+    explicit PollPool(const EventLoop& loop) noexcept : loop(loop) {}
+
+    // A wrapper libuv still holds (open, or closing on a loop that will not run again) is left allocated rather
+    // than freed under the loop.
+    ~PollPool() {
+        std::sort(free_list.begin(), free_list.end());
+        for (auto& slot : slots) {
+            if (!std::binary_search(free_list.begin(), free_list.end(), slot.get())) slot.release();
+        }
+    }
+
+    PollPool(const PollPool&) = delete;
+    PollPool& operator=(const PollPool&) = delete;
+
+    template<typename Fn>
+    void on(Fn&& fn) {
+        handler = std::forward<Fn>(fn);
+    }
+
+    // The open wrapper watching `fd`, or nullptr.
+    inline PollWrapper* find(const curl_socket_t fd) const noexcept {
+        return fd >= 0 && static_cast<std::size_t>(fd) < live.size() ? live[fd] : nullptr;
+    }
+
+    // The wrapper watching `fd`, taken from the free list if it has to be opened. Not started.
+    PollWrapper* acquire(const curl_socket_t fd) {
+        if (PollWrapper* poll = find(fd)) return poll;
+        PollWrapper* poll;
+        if (!free_list.empty()) {
+            poll = free_list.back();
+            free_list.pop_back();
+            poll->open(loop, fd);
+        } else {
+            slots.emplace_back(std::make_unique<PollWrapper>(loop, fd));
+            poll = slots.back().get();
+            poll->on<PollEvent, PollWrapper>([self = this](const PollEvent& event, PollWrapper& wrapper){
+                if (self->handler) self->handler(event, wrapper);
+            });
+            // Close callbacks push onto the free list; never let one allocate.
+            free_list.reserve(slots.size());
+        }
+        if (static_cast<std::size_t>(fd) >= live.size()) live.resize(static_cast<std::size_t>(fd) + 1, nullptr);
+        live[fd] = poll;
+        return poll;
+    }
+
+    // Stops watching `fd`. Its wrapper is reusable once libuv has closed it; should the fd number come back
+    // before then, the new socket simply gets another wrapper.
+    void release(const curl_socket_t fd) noexcept {
+        PollWrapper* poll = find(fd);
+        if (!poll) return;
+        live[fd] = nullptr;
+        poll->close([self = this](PollWrapper* closed){ self->free_list.emplace_back(closed); });
+    }
+
+    // Releases every open wrapper. The loop has to run once more before the pool is destroyed.
+    void close() noexcept {
+        for (std::size_t fd = 0; fd < live.size(); ++fd) release(static_cast<curl_socket_t>(fd));
+    }
+
+    // Wrappers ever allocated, and how many of them are closed and waiting for reuse.
+    inline const std::size_t capacity() const noexcept { return slots.size(); }
+    inline const std::size_t idle() const noexcept { return free_list.size(); }
+
+private:
+    const EventLoop& loop;
+    Handler handler;
+    std::vector<std::unique_ptr<PollWrapper>> slots;
+    std::vector<PollWrapper*> free_list;
+    std::vector<PollWrapper*> live;
+};
+
+#endif
\ No newline at end of file
@@ -11,9 +11,7 @@ class PollWrapper final : public HandleWrapperBase {
 
 public:
     explicit PollWrapper(const EventLoop& loop, int fd) noexcept {
-        this->fd = fd;
-        check_uv_error(uv_poll_init_socket(loop.getLoop(), &poll_handle, fd));
-        poll_handle.data = this;
+        open(loop, fd);
     }
 
     ~PollWrapper() noexcept override {
@@ -27,6 +25,13 @@ public:
         }
     }
 
+    // Points a wrapper whose close has completed at another socket, keeping its callback.
+    void open(const EventLoop& loop, int fd) noexcept {
+        this->fd = fd;
+        check_uv_error(uv_poll_init_socket(loop.getLoop(), &poll_handle, fd));
+        poll_handle.data = this;
+    }
+
     const auto& getFd() const noexcept{
         return fd;
     }
@@ -57,12 +62,11 @@ private:
         PollEvent event;
         event.status = status;
         event.events = events;
-        EventDispatcher::getInstance().dispatch(event, *self);
+        self->emit(event);
     }
 
     static void uv_close_callback(uv_handle_t* handle) noexcept {
         auto* self = static_cast<PollWrapper*>(handle->data);
-        EventDispatcher::getInstance().remove(self);
         if (self->close_callback) {
             self->close_callback(self);
         }
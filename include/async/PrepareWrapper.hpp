@@ -48,12 +48,11 @@ private:
     static void uv_prepare_callback(uv_prepare_t* handle) noexcept {
         auto* self = static_cast<PrepareWrapper*>(handle->data);
         PrepareEvent event;
-        EventDispatcher::getInstance().dispatch(event, *self);
+        self->emit(event);
     }
 
     static void uv_close_callback(uv_handle_t* handle) noexcept {
         auto* self = static_cast<PrepareWrapper*>(handle->data);
-        EventDispatcher::getInstance().remove(self);
         if (self->close_callback) {
             self->close_callback(self);
         }
@@ -43,12 +43,11 @@ private:
     static void uv_timer_callback(uv_timer_t* handle) noexcept {
         auto* self = static_cast<TimerWrapper*>(handle->data);
         TimerEvent event;
-        EventDispatcher::getInstance().dispatch(event, *self);
+        self->emit(event);
     }
 
     static void uv_close_callback(uv_handle_t* handle) noexcept {
         auto* self = static_cast<TimerWrapper*>(handle->data);
-        EventDispatcher::getInstance().remove(self);
         if (self->close_callback) {
             self->close_callback(self);
         }
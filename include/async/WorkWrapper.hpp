@@ -0,0 +1,62 @@
+#ifndef WORKW
+#define WORKW
+
+#include <uv.h>
+#include <functional>
+#include <stdexcept>
+#include "EventLoop.hpp"
+
+// One job at a time on libuv's thread pool: `work` runs on a pool thread, `after` back on the loop thread
+// (status is UV_ECANCELED if the job was cancelled before it started). A request, not a handle, so it keeps
+// the loop alive only while a job is queued or running.
+class WorkWrapper {
+public:
+    using Work = std::function<void()>;
+    using After = std::function<void(int status)>;
+
+    explicit WorkWrapper(const EventLoop& loop) noexcept : loop(loop.getLoop()) {
+        work_req.data = this;
+    }
+
+    WorkWrapper(const WorkWrapper&) = delete;
+    WorkWrapper& operator=(const WorkWrapper&) = delete;
+
+    void queue(Work work, After after = nullptr) {
+        if (busy) throw std::logic_error("A job is already queued on this work request");
+        job = std::move(work);
+        done = std::move(after);
+        if (const int ret = uv_queue_work(loop, &work_req, uv_work_callback, uv_after_callback); ret != 0) {
+            throw std::runtime_error(uv_strerror(ret));
+        }
+        busy = true;
+    }
+
+    // Only succeeds while the job is still waiting for a pool thread.
+    const bool cancel() noexcept {
+        return busy && uv_cancel(reinterpret_cast<uv_req_t*>(&work_req)) == 0;
+    }
+
+    inline const bool isBusy() const noexcept { return busy; }
+
+private:
+    uv_loop_t* loop;
+    uv_work_t work_req{};
+    Work job;
+    After done;
+    bool busy {false};
+
+    static void uv_work_callback(uv_work_t* req) noexcept {
+        auto* self = static_cast<WorkWrapper*>(req->data);
+        if (self->job) self->job();
+    }
+
+    static void uv_after_callback(uv_work_t* req, int status) {
+        auto* self = static_cast<WorkWrapper*>(req->data);
+        self->busy = false;
+        After after = std::move(self->done);
+        self->job = nullptr;
+        if (after) after(status);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef BODYSINK
+#define BODYSINK
+
+#include <cstddef>
+
+// Sees a response body chunk by chunk as curl receives it, from inside the write callback.
+// Returning false from write() aborts the transfer (CURLE_WRITE_ERROR); write() must not throw.
+class BodySink {
+public:
+    virtual ~BodySink() = default;
+
+    virtual bool write(const char* ptr, std::size_t len) noexcept = 0;
+
+    // Called when the owning handle is given a new URL; drop whatever the last transfer left behind.
+    virtual void reset() noexcept {}
+};
+
+#endif
\ No newline at end of file
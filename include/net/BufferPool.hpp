@@ -0,0 +1,242 @@
+#ifndef BUFFERP
+#define BUFFERP
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// A slab is one allocation: this header followed by `capacity` bytes of payload.
+struct Slab {
+    Slab* next;
+    std::size_t used;
+    std::size_t capacity;
+    unsigned size_class;
+
+    inline char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+    inline const char* data() const noexcept { return reinterpret_cast<const char*>(this + 1); }
+};
+
+// Recycles response slabs in a few size classes. Slabs beyond the high-water mark are freed on release,
+// so a burst of large pages does not pin memory forever. Safe to use from several threads.
+class SlabPool {
+public:
+    static constexpr std::size_t class_count = 4;
+    static constexpr std::array<std::size_t, class_count> class_sizes { 4096, 16384, 65536, 262144 };
+
+private:
+    std::array<Slab*, class_count> free_lists {};
+    std::size_t cached_bytes {0};
+    std::size_t high_water;
+    std::mutex mtx;
+
+public:
+    explicit SlabPool(const std::size_t high_water_bytes = 64 * 1024 * 1024) noexcept : high_water(high_water_bytes) {}
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool() noexcept {
+        trim(0);
+    }
+
+    static SlabPool& global() {
+        static SlabPool instance;
+        return instance;
+    }
+
+    Slab* acquire(const unsigned size_class) {
+        const unsigned c = size_class < class_count ? size_class : class_count - 1;
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (Slab* slab = free_lists[c]) {
+                free_lists[c] = slab->next;
+                cached_bytes -= class_sizes[c];
+                slab->next = nullptr;
+                slab->used = 0;
+                return slab;
+            }
+        }
+        Slab* slab = static_cast<Slab*>(::operator new(sizeof(Slab) + class_sizes[c]));
+        slab->next = nullptr;
+        slab->used = 0;
+        slab->capacity = class_sizes[c];
+        slab->size_class = c;
+        return slab;
+    }
+
+    // Takes back a whole list of slabs linked through `next`.
+    void release(Slab* slab) noexcept {
+        Slab* overflow = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            while (slab) {
+                Slab* next = slab->next;
+                if (cached_bytes + slab->capacity <= high_water) {
+                    slab->next = free_lists[slab->size_class];
+                    free_lists[slab->size_class] = slab;
+                    cached_bytes += slab->capacity;
+                } else {
+                    slab->next = overflow;
+                    overflow = slab;
+                }
+                slab = next;
+            }
+        }
+        while (overflow) {
+            Slab* next = overflow->next;
+            ::operator delete(overflow);
+            overflow = next;
+        }
+    }
+
+    // Frees cached slabs until at most `bytes` remain cached.
+    void trim(const std::size_t bytes) noexcept {
+        std::lock_guard<std::mutex> guard(mtx);
+        for (std::size_t c = class_count; c-- > 0 && cached_bytes > bytes;) {
+            while (free_lists[c] && cached_bytes > bytes) {
+                Slab* slab = free_lists[c];
+                free_lists[c] = slab->next;
+                cached_bytes -= slab->capacity;
+                ::operator delete(slab);
+            }
+        }
+    }
+
+    void setHighWater(const std::size_t bytes) noexcept {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            high_water = bytes;
+        }
+        trim(bytes);
+    }
+
+    const std::size_t cachedBytes() noexcept {
+        std::lock_guard<std::mutex> guard(mtx);
+        return cached_bytes;
+    }
+};
+
+// A response body as a list of pooled slabs. Appending never moves bytes already written, and moving a chain
+// just hands over the list. When the body's length is known (expect()), slabs are cut to fit it, leaving at most
+// one small slab part-empty; otherwise a chain takes `run_length` slabs of a class before stepping up to the
+// next, so the slack stays a fraction of the body rather than a multiple of it.
+class ChunkChain {
+    static constexpr unsigned run_length = 4;
+
+    Slab* head {nullptr};
+    Slab* tail {nullptr};
+    std::size_t total {0};
+    std::size_t expected {0};
+    unsigned run {0};
+    SlabPool* pool;
+
+    unsigned nextClass() const noexcept {
+        if (expected > total) {
+            const std::size_t rest = expected - total;
+            unsigned c = 0;
+            while (c + 1 < SlabPool::class_count && SlabPool::class_sizes[c + 1] <= rest) ++c;
+            return c;
+        }
+        if (!tail) return 0;
+        return run < run_length ? tail->size_class : tail->size_class + 1;
+    }
+
+public:
+    class const_iterator {
+        const Slab* slab;
+    public:
+        explicit const_iterator(const Slab* s) noexcept : slab(s) {}
+        std::string_view operator*() const noexcept { return std::string_view(slab->data(), slab->used); }
+        const_iterator& operator++() noexcept { slab = slab->next; return *this; }
+        bool operator==(const const_iterator& other) const noexcept { return slab == other.slab; }
+        bool operator!=(const const_iterator& other) const noexcept { return slab != other.slab; }
+    };
+
+    explicit ChunkChain(SlabPool& p = SlabPool::global()) noexcept : pool(&p) {}
+
+    ChunkChain(ChunkChain&& other) noexcept : head(other.head), tail(other.tail), total(other.total),
+        expected(other.expected), run(other.run), pool(other.pool) {
+        other.head = other.tail = nullptr;
+        other.total = other.expected = 0;
+        other.run = 0;
+    }
+
+    ChunkChain& operator=(ChunkChain&& other) noexcept {
+        if (this != &other) {
+            clear();
+            head = other.head;
+            tail = other.tail;
+            total = other.total;
+            expected = other.expected;
+            run = other.run;
+            pool = other.pool;
+            other.head = other.tail = nullptr;
+            other.total = other.expected = 0;
+            other.run = 0;
+        }
+        return *this;
+    }
+
+    ChunkChain(const ChunkChain&) = delete;
+    ChunkChain& operator=(const ChunkChain&) = delete;
+
+    ~ChunkChain() noexcept {
+        clear();
+    }
+
+    // The whole body will be about `bytes` long, e.g. from Content-Length. A wrong guess only costs slack.
+    void expect(const std::size_t bytes) noexcept {
+        expected = bytes;
+    }
+
+    void append(const char* ptr, std::size_t len) {
+        while (len) {
+            if (!tail || tail->used == tail->capacity) {
+                Slab* slab = pool->acquire(nextClass());
+                run = tail && tail->size_class == slab->size_class ? run + 1 : 1;
+                if (tail) tail->next = slab;
+                else head = slab;
+                tail = slab;
+            }
+            const std::size_t n = std::min(len, tail->capacity - tail->used);
+            std::memcpy(tail->data() + tail->used, ptr, n);
+            tail->used += n;
+            total += n;
+            ptr += n;
+            len -= n;
+        }
+    }
+
+    void clear() noexcept {
+        if (head) pool->release(head);
+        head = tail = nullptr;
+        total = expected = 0;
+        run = 0;
+    }
+
+    inline const std::size_t size() const noexcept { return total; }
+    inline const bool empty() const noexcept { return total == 0; }
+
+    const_iterator begin() const noexcept { return const_iterator(head); }
+    const_iterator end() const noexcept { return const_iterator(nullptr); }
+
+    // Flattens into one string; only for callers that really need contiguous bytes.
+    std::string str() const {
+        std::string s;
+        s.reserve(total);
+        for (const auto chunk : *this) s.append(chunk.data(), chunk.size());
+        return s;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const ChunkChain& chain) {
+        for (const auto chunk : chain) os.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        return os;
+    }
+};
+
+#endif
\ No newline at end of file
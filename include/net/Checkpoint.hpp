@@ -0,0 +1,283 @@
+#ifndef CHECKPOINT
+#define CHECKPOINT
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "SpillStore.hpp"
+
+// What changed in the frontier since the last checkpoint: fingerprints added to the visited set, requests
+// queued (SpillStore records, their tie doubling as a ticket) and tickets of requests that completed.
+// `reset` means the frontier was cleared, so everything queued before it is gone.
+struct CrawlJournal {
+    std::string visited;
+    std::string queued;
+    std::string done;
+    std::size_t queued_count {0};
+    uint64_t sequence {0};
+    bool reset {false};
+
+    void addVisited(const uint64_t fp) { visited.append(reinterpret_cast<const char*>(&fp), sizeof fp); }
+    void addDone(const uint64_t ticket) { done.append(reinterpret_cast<const char*>(&ticket), sizeof ticket); }
+
+    void addQueued(const SpilledRequest& item) {
+        SpillStore::encodeRecord(queued, item, 0);
+        ++queued_count;
+    }
+
+    const bool empty() const noexcept {
+        return visited.empty() && queued.empty() && done.empty() && !reset;
+    }
+
+    void clear() noexcept {
+        visited.clear();
+        queued.clear();
+        done.clear();
+        queued_count = 0;
+        reset = false;
+    }
+};
+
+// Crawl state on disk, as three append-only logs and a small state file naming how much of each is valid:
+//   visited.log      fingerprints, never rewritten
+//   queued.<gen>.log every request queued since generation <gen> began
+//   done.<gen>.log   tickets of those that completed
+// A checkpoint appends the journal, syncs, then atomically replaces `state`; a crash at any point leaves the
+// previous checkpoint intact. Once most of the queued log is done it is compacted into a new generation.
+// Profiles are not saved: resumed requests take the options of the loop that fetches them.
+class CheckpointStore {
+    static constexpr char magic[8] = {'H', 'P', 'S', 'C', 'K', 'P', 'T', '1'};
+
+    struct State {
+        uint64_t generation {0};
+        uint64_t visited_len {0};
+        uint64_t queued_len {0};
+        uint64_t queued_count {0};
+        uint64_t done_len {0};
+        uint64_t sequence {0};
+    };
+
+    std::string dir;
+    State state;
+
+    std::string path(const std::string& name) const { return dir + "/" + name; }
+    std::string queuedPath(const uint64_t gen) const { return path("queued." + std::to_string(gen) + ".log"); }
+    std::string donePath(const uint64_t gen) const { return path("done." + std::to_string(gen) + ".log"); }
+
+    [[noreturn]] static void fail(const std::string& what, const std::string& file) {
+        throw std::runtime_error(what + " " + file + ": " + std::strerror(errno));
+    }
+
+    // Writes at `offset`, past whatever a crashed run may have left beyond the last checkpoint.
+    static void writeAt(const std::string& file, const std::string& data, const uint64_t offset) {
+        const int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) fail("Cannot open", file);
+        const char* p = data.data();
+        std::size_t n = data.size();
+        off_t at = static_cast<off_t>(offset);
+        while (n) {
+            const ssize_t w = ::pwrite(fd, p, n, at);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                ::close(fd);
+                fail("Cannot write", file);
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+            at += w;
+        }
+        if (::fdatasync(fd) != 0) {
+            ::close(fd);
+            fail("Cannot sync", file);
+        }
+        ::close(fd);
+    }
+
+    // Maps the first `len` bytes of `file` and hands them to `fn`.
+    template<typename Fn>
+    static void withMapped(const std::string& file, const uint64_t len, Fn&& fn) {
+        if (!len) return;
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) fail("Cannot open", file);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < len) {
+            ::close(fd);
+            throw std::runtime_error("Checkpoint log " + file + " is shorter than its state says");
+        }
+        void* map = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) fail("Cannot map", file);
+        ::madvise(map, len, MADV_SEQUENTIAL);
+        try {
+            fn(static_cast<const unsigned char*>(map), static_cast<std::size_t>(len));
+        } catch (...) {
+            ::munmap(map, len);
+            throw;
+        }
+        ::munmap(map, len);
+    }
+
+    std::unordered_set<uint64_t> doneTickets() const {
+        std::unordered_set<uint64_t> done;
+        done.reserve(state.done_len / sizeof(uint64_t));
+        withMapped(donePath(state.generation), state.done_len, [&](const unsigned char* p, const std::size_t n) {
+            for (std::size_t i = 0; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+                uint64_t t;
+                std::memcpy(&t, p + i, sizeof t);
+                done.insert(t);
+            }
+        });
+        return done;
+    }
+
+    // Calls `fn` with every request of the current generation that has not completed.
+    template<typename Fn>
+    void forEachLive(Fn&& fn) const {
+        const auto done = doneTickets();
+        withMapped(queuedPath(state.generation), state.queued_len, [&](const unsigned char* p, const std::size_t n) {
+            const unsigned char* const end = p + n;
+            while (p != end) {
+                SpilledRequest item;
+                uint32_t profile_id;
+                p = SpillStore::decodeRecord(p, end, item, profile_id);
+                if (!done.count(item.tie)) fn(std::move(item));
+            }
+        });
+    }
+
+    void writeState() const {
+        std::string data(magic, sizeof magic);
+        data.append(reinterpret_cast<const char*>(&state), sizeof state);
+        const std::string tmp = path("state.tmp");
+        const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) fail("Cannot create", tmp);
+        const bool ok = ::write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()) && ::fsync(fd) == 0;
+        ::close(fd);
+        if (!ok) fail("Cannot write", tmp);
+        if (::rename(tmp.c_str(), path("state").c_str()) != 0) fail("Cannot replace", path("state"));
+        const int dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dfd >= 0) {
+            ::fsync(dfd);
+            ::close(dfd);
+        }
+    }
+
+    // Starts generation `gen + 1` holding `queued` (live records only) and no tickets.
+    void beginGeneration(const std::string& queued, const uint64_t count) {
+        const uint64_t old = state.generation;
+        ++state.generation;
+        ::unlink(queuedPath(state.generation).c_str());
+        ::unlink(donePath(state.generation).c_str());
+        writeAt(queuedPath(state.generation), queued, 0);
+        writeAt(donePath(state.generation), std::string(), 0);
+        state.queued_len = queued.size();
+        state.queued_count = count;
+        state.done_len = 0;
+        writeState();
+        ::unlink(queuedPath(old).c_str());
+        ::unlink(donePath(old).c_str());
+    }
+
+    void compact() {
+        std::string live;
+        uint64_t count = 0;
+        forEachLive([&](SpilledRequest&& item) {
+            SpillStore::encodeRecord(live, item, 0);
+            ++count;
+        });
+        beginGeneration(live, count);
+    }
+
+public:
+    explicit CheckpointStore(std::string directory) : dir(std::move(directory)) {
+        struct stat st {};
+        if (::stat(dir.c_str(), &st) != 0) {
+            if (::mkdir(dir.c_str(), 0700) != 0) fail("Cannot create checkpoint directory", dir);
+        } else if (!S_ISDIR(st.st_mode)) {
+            throw std::invalid_argument("Checkpoint path is not a directory: " + dir);
+        }
+    }
+
+    // Reads `state`; false when the directory holds no checkpoint yet.
+    const bool open() {
+        const std::string file = path("state");
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT) return false;
+            fail("Cannot open", file);
+        }
+        char data[sizeof magic + sizeof(State)];
+        const ssize_t n = ::read(fd, data, sizeof data);
+        ::close(fd);
+        if (n != static_cast<ssize_t>(sizeof data) || std::memcmp(data, magic, sizeof magic) != 0) {
+            throw std::runtime_error("Not a checkpoint: " + file);
+        }
+        std::memcpy(&state, data + sizeof magic, sizeof state);
+        return true;
+    }
+
+    // Forgets any previous checkpoint in the directory.
+    void start() {
+        if (open()) {
+            ::unlink(queuedPath(state.generation).c_str());
+            ::unlink(donePath(state.generation).c_str());
+        }
+        ::unlink(path("visited.log").c_str());
+        state = State{};
+        writeAt(path("visited.log"), std::string(), 0);
+        writeAt(queuedPath(0), std::string(), 0);
+        writeAt(donePath(0), std::string(), 0);
+        writeState();
+    }
+
+    // Replays the checkpoint read by open(): `visit` gets every visited fingerprint, `queue` every request that
+    // was queued or in flight. Returns how many requests were handed back.
+    template<typename Visit, typename Queue>
+    std::size_t load(Visit&& visit, Queue&& queue) const {
+        withMapped(path("visited.log"), state.visited_len, [&](const unsigned char* p, const std::size_t n) {
+            for (std::size_t i = 0; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+                uint64_t fp;
+                std::memcpy(&fp, p + i, sizeof fp);
+                visit(fp);
+            }
+        });
+        std::size_t count = 0;
+        forEachLive([&](SpilledRequest&& item) {
+            queue(std::move(item));
+            ++count;
+        });
+        return count;
+    }
+
+    inline const uint64_t sequence() const noexcept { return state.sequence; }
+
+    // Appends `journal` and commits it. Blocking; meant for a thread-pool job.
+    void write(const CrawlJournal& journal) {
+        if (journal.reset) beginGeneration(std::string(), 0);
+
+        writeAt(path("visited.log"), journal.visited, state.visited_len);
+        writeAt(queuedPath(state.generation), journal.queued, state.queued_len);
+        writeAt(donePath(state.generation), journal.done, state.done_len);
+        state.visited_len += journal.visited.size();
+        state.queued_len += journal.queued.size();
+        state.queued_count += journal.queued_count;
+        state.done_len += journal.done.size();
+        state.sequence = journal.sequence;
+        writeState();
+
+        const uint64_t done = state.done_len / sizeof(uint64_t);
+        if (done >= 4096 && done * 2 >= state.queued_count) compact();
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#ifndef CONCURRENCY
+#define CONCURRENCY
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <utility>
+#include <curl/curl.h>
+
+// A snapshot of what the controller decided and why: the current cap, smoothed latency against its baseline,
+// smoothed error rate, and how often the cap went up or down.
+struct ConcurrencyMetrics {
+    std::size_t limit {0};
+    std::size_t in_flight {0};
+    double latency_ms {0};
+    double baseline_ms {0};
+    double error_rate {0};
+    uint64_t increases {0};
+    uint64_t decreases {0};
+};
+
+// AIMD control of how many transfers run at once, overall and per host. Every completion feeds its latency and
+// outcome in: a healthy one (latency within `tolerance` times the baseline, no congestion error) raises the cap
+// by `increase` per cap's worth of completions; a slow one, a timeout, a refused connection or a 429/503 cuts
+// it by `decrease`, at most once per smoothed latency so one burst of failures counts once.
+// The baseline is the lowest smoothed latency seen, drifting up slowly so it follows a network that got slower.
+// Safe to share between loops.
+class ConcurrencyController {
+    struct Signal {
+        double limit;
+        double latency {0};
+        double baseline {0};
+        double errors {0};
+        uint64_t last_decrease {0};
+        uint64_t increases {0};
+        uint64_t decreases {0};
+        std::size_t in_flight {0};
+    };
+
+    static constexpr double smoothing = 0.2;
+    static constexpr double baseline_drift = 0.01;
+
+    std::size_t min_limit;
+    std::size_t max_limit;
+    std::size_t host_max;
+    double increase {1.0};
+    double decrease {0.7};
+    double tolerance {2.0};
+    Signal global;
+    std::unordered_map<std::string, Signal> hosts;
+    bool starved {false};
+    mutable std::mutex mtx;
+
+    static uint64_t now() noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static const bool congestion(const long response_code, const CURLcode result) noexcept {
+        switch (result) {
+            case CURLE_OK: return response_code == 429 || response_code == 503;
+            case CURLE_OPERATION_TIMEDOUT:
+            case CURLE_COULDNT_CONNECT:
+            case CURLE_SEND_ERROR:
+            case CURLE_RECV_ERROR:
+            case CURLE_GOT_NOTHING:
+                return true;
+            default: return false;
+        }
+    }
+
+    // Returns true when the whole-number cap changed.
+    const bool update(Signal& s, const double latency, const bool failed, const std::size_t lo, const std::size_t hi, const uint64_t t) {
+        const std::size_t before = static_cast<std::size_t>(s.limit);
+        s.latency = s.latency ? s.latency + smoothing * (latency - s.latency) : latency;
+        s.errors += smoothing * ((failed ? 1.0 : 0.0) - s.errors);
+        if (!s.baseline || s.latency < s.baseline) s.baseline = s.latency;
+        else s.baseline += baseline_drift * (s.latency - s.baseline);
+
+        const bool slow = s.latency > s.baseline * tolerance;
+        if (failed || slow) {
+            const uint64_t cooldown = std::max<uint64_t>(100, static_cast<uint64_t>(s.latency * 1000));
+            if (t >= s.last_decrease + cooldown) {
+                s.limit = std::max(static_cast<double>(lo), s.limit * decrease);
+                s.last_decrease = t;
+                ++s.decreases;
+            }
+        } else if (s.limit < hi) {
+            s.limit = std::min(static_cast<double>(hi), s.limit + increase / s.limit);
+            if (static_cast<std::size_t>(s.limit) != before) ++s.increases;
+        }
+        return static_cast<std::size_t>(s.limit) != before;
+    }
+
+    static ConcurrencyMetrics snapshot(const Signal& s) {
+        return ConcurrencyMetrics{static_cast<std::size_t>(s.limit), s.in_flight, s.latency * 1000, s.baseline * 1000,
+                                  s.errors, s.increases, s.decreases};
+    }
+
+public:
+    // Caps start at `initial` overall and `max_per_host` per host, and move within [min, max] and [1, max_per_host].
+    ConcurrencyController(const std::size_t min, const std::size_t max, const std::size_t max_per_host, const std::size_t initial) :
+        min_limit(min), max_limit(max), host_max(max_per_host) {
+        if (!min || min > max || !max_per_host) throw std::invalid_argument("Concurrency limits must satisfy 0 < min <= max, per host > 0");
+        global.limit = static_cast<double>(std::clamp(initial, min, max));
+    }
+
+    ConcurrencyController(const ConcurrencyController&) = delete;
+    ConcurrencyController& operator=(const ConcurrencyController&) = delete;
+
+    // `increase` is added per cap's worth of healthy completions, `decrease` multiplies the cap on congestion,
+    // and latency counts as congestion past `tolerance` times the baseline.
+    void setTuning(const double inc, const double dec, const double tol) {
+        if (inc <= 0 || dec <= 0 || dec >= 1 || tol <= 1) throw std::invalid_argument("Need increase > 0, 0 < decrease < 1, tolerance > 1");
+        std::lock_guard<std::mutex> guard(mtx);
+        increase = inc;
+        decrease = dec;
+        tolerance = tol;
+    }
+
+    // Takes a slot if the overall cap allows one more transfer.
+    const bool tryAcquire() {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (global.in_flight >= static_cast<std::size_t>(global.limit)) {
+            starved = true;
+            return false;
+        }
+        ++global.in_flight;
+        return true;
+    }
+
+    // True once after tryAcquire() turned someone away, so loops sharing the controller know to wake each other.
+    const bool takeStarved() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return std::exchange(starved, false);
+    }
+
+    // Gives slots back without a measurement, for transfers that never ran or were abandoned.
+    void release(const std::size_t n = 1) {
+        std::lock_guard<std::mutex> guard(mtx);
+        global.in_flight = n < global.in_flight ? global.in_flight - n : 0;
+    }
+
+    // Records a finished transfer to `host` and gives its slot back. Returns the host's new cap when it
+    // changed, 0 otherwise.
+    std::size_t complete(const std::string& host, const double seconds, const long response_code, const CURLcode result) {
+        // A name that does not resolve says nothing about load.
+        const bool measured = result != CURLE_COULDNT_RESOLVE_HOST && result != CURLE_COULDNT_RESOLVE_PROXY;
+        const bool failed = congestion(response_code, result);
+        const uint64_t t = now();
+        std::lock_guard<std::mutex> guard(mtx);
+        global.in_flight = global.in_flight ? global.in_flight - 1 : 0;
+        if (!measured) return 0;
+        update(global, seconds, failed, min_limit, max_limit, t);
+        auto [it, inserted] = hosts.try_emplace(host);
+        if (inserted) it->second.limit = static_cast<double>(host_max);
+        return update(it->second, seconds, failed, 1, host_max, t) ? static_cast<std::size_t>(it->second.limit) : 0;
+    }
+
+    inline const std::size_t maxLimit() const noexcept { return max_limit; }
+    inline const std::size_t maxPerHost() const noexcept { return host_max; }
+
+    const std::size_t limit() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return static_cast<std::size_t>(global.limit);
+    }
+
+    ConcurrencyMetrics metrics() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return snapshot(global);
+    }
+
+    // Per-host figures; in_flight is not tracked per host (the frontier does that).
+    ConcurrencyMetrics hostMetrics(const std::string& host) const {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = hosts.find(host);
+        if (it == hosts.end()) return ConcurrencyMetrics{host_max};
+        return snapshot(it->second);
+    }
+};
+
+#endif
\ No newline at end of file
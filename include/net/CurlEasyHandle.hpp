@@ -2,11 +2,16 @@
 #define CURLEH
 
 #include <curl/curl.h>
+#include "BufferPool.hpp"
+#include "BodySink.hpp"
+#include "CurlShare.hpp"
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <functional>
 
+class OptionProfile;
+
 enum HTTP {
     HTTP1 = CURL_HTTP_VERSION_1_0,
     HTTP1_1 = CURL_HTTP_VERSION_1_1,
@@ -19,12 +24,25 @@ enum HTTP {
 };
 
 class CurlEasyHandle {
+    static constexpr curl_off_t default_max_file_size = 2 * 1024 * 1024;
+
+    const std::size_t base_buffer_sz;
+    const long base_mstimeout;
     std::size_t curl_buffer_sz;
     long curl_mstimeout;
     std::size_t depth;
-    std::string buf;
+    std::string request_url;
+    ChunkChain buf;
+    std::unique_ptr<BodySink> sink;
+    bool keep_body {true};
+    curl_off_t max_file_size {default_max_file_size};
+    // Before the handle, so the share and the pin list outlive it.
+    std::shared_ptr<CurlShare> share_;
+    std::shared_ptr<struct curl_slist> resolve_;
     std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl_handle_ ;
     std::unique_ptr<struct curl_slist, decltype(&curl_slist_free_all)> headers_;
+    std::shared_ptr<const OptionProfile> profile_;
+    bool customized {false};
     
     static inline void checkSetOpt(const CURLcode&& res, const char* opt_name) noexcept{
         if(res != CURLE_OK) std::cerr << "Failed to set " << opt_name << ": " << curl_easy_strerror(res) << '\n';
@@ -37,14 +55,24 @@ class CurlEasyHandle {
 
     static std::size_t write_callback(char* ptr, std::size_t size, std::size_t nmemb, void* userdata) {
         const std::size_t totalSize = size * nmemb;
-        static_cast<std::string*>(userdata)->append(ptr, totalSize);
+        auto self = static_cast<CurlEasyHandle*>(userdata);
+        if (self->keep_body) {
+            // The headers are in by the first write, so the slabs can be sized to the body from the start.
+            if (self->buf.empty()) {
+                curl_off_t length = -1;
+                if (curl_easy_getinfo(self->curl_handle_.get(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK && length > 0) {
+                    self->buf.expect(static_cast<std::size_t>(length));
+                }
+            }
+            self->buf.append(ptr, totalSize);
+        }
+        if (self->sink && !self->sink->write(ptr, totalSize)) return 0;
         return totalSize;
     }
 
     void setInternalOptions() noexcept{
         setOption(CURLOPT_PRIVATE,static_cast<void*>(this), "CURLOPT_PRIVATE");
-        setOption(CURLOPT_MAXFILESIZE, 2 * 1024 * 1024,"CURLOPT_MAXFILESIZE");
-        setOption(CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4, "CURLOPT_IPRESOLVE");
+        setOption(CURLOPT_MAXFILESIZE_LARGE, max_file_size, "CURLOPT_MAXFILESIZE_LARGE");
         setOption(CURLOPT_TCP_NODELAY, 1L, "CURLOPT_TCP_NODELAY");
         setOption(CURLOPT_CONNECTTIMEOUT_MS, 6000, "CURLOPT_CONNECTTIMEOUT_MS");
         setOption(CURLOPT_EXPECT_100_TIMEOUT_MS, 0L, "CURLOPT_EXPECT_100_TIMEOUT_MS");
@@ -52,12 +80,16 @@ class CurlEasyHandle {
         #if LIBCURL_VERSION_NUM >= 0x071900
             setOption(CURLOPT_TCP_KEEPALIVE, 1L, "CURLOPT_TCP_KEEPALIVE");
         #endif
+        // curl_easy_reset drops both, so they are set again with the other internals.
+        if (share_) setOption(CURLOPT_SHARE, share_->get(), "CURLOPT_SHARE");
+        if (resolve_) setOption(CURLOPT_RESOLVE, resolve_.get(), "CURLOPT_RESOLVE");
     }
 
     void initialiseInitialOptions() noexcept{
         setInternalOptions();
-        setWriteCallback(write_callback , &buf);
+        setWriteCallback(write_callback , this);
         setHTTPVersion(HTTP::HTTP1_1);
+        setIPResolve(CURL_IPRESOLVE_V4);
         setBufferSize(curl_buffer_sz);
         setAcceptEncoding("");
         setFollowRedirects(true);
@@ -70,11 +102,10 @@ class CurlEasyHandle {
 
 public:
 
-    CurlEasyHandle(const std::size_t buffer_sz, const long timeout): curl_buffer_sz(buffer_sz), curl_mstimeout(timeout),depth(0),
+    CurlEasyHandle(const std::size_t buffer_sz, const long timeout): base_buffer_sz(buffer_sz), base_mstimeout(timeout), curl_buffer_sz(buffer_sz), curl_mstimeout(timeout),depth(0),
     curl_handle_(curl_easy_init(), &curl_easy_cleanup),
     headers_(nullptr, &curl_slist_free_all)
     {
-            buf.reserve(buffer_sz);
             if (!curl_handle_) throw std::runtime_error("Failed to initialize curl handle.");
                 initialiseInitialOptions();
     }
@@ -97,10 +128,32 @@ public:
         long headerSize;
         long requestSize;
         long responseCode;
+        // Validators, for revalidating a cached copy later.
+        std::string etag;
+        std::string lastModified;
+        // Served from the response cache after the server answered 304 Not Modified.
+        bool fromCache {false};
+        // Set on a fresh 200 the response cache should keep, to the URL it is kept under. The loop writes the
+        // body out once the response has been delivered.
+        std::string cacheUrl;
         const std::size_t depth;
-        const std::string& message;
+        ChunkChain body;
+        const ChunkChain& message;
+
+        Response(CURL* handle , const std::size_t d, const ChunkChain& buf) : depth(d), message(buf) {
+            readInfo(handle);
+        }
 
-        Response(CURL* handle , const std::size_t d, const std::string& buf) : depth(d), message(buf) {
+        // Takes the slabs over, so the response outlives the handle it came from without copying the body.
+        Response(CURL* handle , const std::size_t d, ChunkChain&& buf) : depth(d), body(std::move(buf)), message(body) {
+            readInfo(handle);
+        }
+
+        Response(const Response&) = delete;
+        Response& operator=(const Response&) = delete;
+
+    private:
+        void readInfo(CURL* handle) {
             char* tempStr; 
 
             if (CURLE_OK == curl_easy_getinfo(handle, CURLINFO_CONTENT_TYPE, &tempStr) && tempStr)
@@ -130,6 +183,14 @@ public:
             curl_easy_getinfo(handle, CURLINFO_HEADER_SIZE, &headerSize);
             curl_easy_getinfo(handle, CURLINFO_REQUEST_SIZE, &requestSize);
             curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &responseCode);
+
+            // curl_easy_header arrived in 7.83. Older builds leave both validators empty, so cached pages are
+            // fetched in full instead of revalidated.
+            #if LIBCURL_VERSION_NUM >= 0x075300
+                struct curl_header* header;
+                if (curl_easy_header(handle, "ETag", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) etag = header->value;
+                if (curl_easy_header(handle, "Last-Modified", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) lastModified = header->value;
+            #endif
         }
     };
 
@@ -186,6 +247,12 @@ public:
         for (const auto& header : headers) addHeader(header);
     }
 
+    // Points the handle at a list owned elsewhere (e.g. by an OptionProfile) that outlives the transfer.
+    void useHeaderList(struct curl_slist* list) noexcept {
+        headers_.reset(nullptr);
+        setOption(CURLOPT_HTTPHEADER, list, "CURLOPT_HTTPHEADER");
+    }
+
     void clearHeaders() noexcept {
         headers_.reset(nullptr);
         setOption(CURLOPT_HTTPHEADER, nullptr, "CURLOPT_HTTPHEADER");
@@ -200,6 +267,12 @@ public:
         setOption(CURLOPT_TIMEOUT_MS, tm, "CURLOPT_TIMEOUT_MS");
     }
 
+    // Transfers announcing a larger body fail up front; 2 MB by default.
+    void setMaxFileSize(const curl_off_t bytes) noexcept{
+        max_file_size = bytes;
+        setOption(CURLOPT_MAXFILESIZE_LARGE, bytes, "CURLOPT_MAXFILESIZE_LARGE");
+    }
+
     void setDepth(const std::size_t d) noexcept{ depth = d; }
 
     std::size_t getDepth() const noexcept{ return depth; } 
@@ -213,12 +286,93 @@ public:
 	}
 
     void reset() noexcept{
-        curl_easy_reset(curl_handle_.get());
         buf.clear();
         depth = 0;
+        resetOptions();
+    }
+
+    // Back to the defaults the handle was built with; the body and depth are left alone.
+    void resetOptions() noexcept{
+        // curl_easy_reset forgets the cookie-file list without freeing it; a null COOKIEFILE frees it first.
+        setOption(CURLOPT_COOKIEFILE, static_cast<const char*>(nullptr), "CURLOPT_COOKIEFILE");
+        curl_easy_reset(curl_handle_.get());
+        // Older libcurl keeps the receive buffer of a transfer that failed early across a reset, yet forgets its size
+        // and refuses a new one; the next transfer would overrun it. Such a handle is replaced.
+        if (curl_easy_setopt(curl_handle_.get(), CURLOPT_BUFFERSIZE, static_cast<long>(base_buffer_sz)) != CURLE_OK) {
+            if (CURL* fresh = curl_easy_init()) curl_handle_.reset(fresh);
+        }
+        headers_.reset(nullptr);
+        profile_.reset();
+        customized = false;
+        curl_buffer_sz = base_buffer_sz;
+        curl_mstimeout = base_mstimeout;
+        max_file_size = default_max_file_size;
         initialiseInitialOptions();
     }
 
+    // Records which profile the handle's options came from; applying it is the pool's job.
+    void setProfile(std::shared_ptr<const OptionProfile> p) noexcept{
+        profile_ = std::move(p);
+    }
+
+    const OptionProfile* getProfile() const noexcept{
+        return profile_.get();
+    }
+
+    // Set once per-request overrides were applied on top of the profile; the next request must start from a reset.
+    void setCustomized(const bool val) noexcept{
+        customized = val;
+    }
+
+    const bool isCustomized() const noexcept{
+        return customized;
+    }
+
+    // CURL_IPRESOLVE_V4 (the default), CURL_IPRESOLVE_V6 or CURL_IPRESOLVE_WHATEVER.
+    void setIPResolve(const long version) noexcept{
+        setOption(CURLOPT_IPRESOLVE, version, "CURLOPT_IPRESOLVE");
+    }
+
+    // Attaches the handle to `share`'s caches; only while it is not in a transfer.
+    void setShare(std::shared_ptr<CurlShare> share) noexcept{
+        share_ = std::move(share);
+        setOption(CURLOPT_SHARE, share_ ? share_->get() : nullptr, "CURLOPT_SHARE");
+    }
+
+    const CurlShare* getShare() const noexcept{
+        return share_.get();
+    }
+
+    // Host pins for the next transfers, as built by CurlShare::resolveList.
+    void setResolveList(std::shared_ptr<struct curl_slist> list) noexcept{
+        resolve_ = std::move(list);
+        setOption(CURLOPT_RESOLVE, resolve_.get(), "CURLOPT_RESOLVE");
+    }
+
+    const struct curl_slist* getResolveList() const noexcept{
+        return resolve_.get();
+    }
+
+    // Adds one CURLOPT_RESOLVE entry to the current list for this handle only; the pool puts the shared pins
+    // back on its next acquire.
+    void addResolve(const std::string& entry) {
+        struct curl_slist* list = nullptr;
+        for (const struct curl_slist* it = resolve_.get(); it; it = it->next) {
+            struct curl_slist* next = curl_slist_append(list, it->data);
+            if (!next) {
+                curl_slist_free_all(list);
+                throw std::bad_alloc();
+            }
+            list = next;
+        }
+        struct curl_slist* next = curl_slist_append(list, entry.c_str());
+        if (!next) {
+            curl_slist_free_all(list);
+            throw std::bad_alloc();
+        }
+        setResolveList(std::shared_ptr<struct curl_slist>(next, &curl_slist_free_all));
+    }
+
     void setMultiplexing(bool val){
         setOption(CURLOPT_PIPEWAIT, val ? 1L : 0L ,"CURLOPT_PIPEWAIT");
     }
@@ -261,11 +415,19 @@ public:
     }
 
     void setPostFields(const std::string& postFields) noexcept {
-        setOption(CURLOPT_POSTFIELDSIZE, postFields.length() + 1, "CURLOPT_POSTFIELDS");
+        setOption(CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(postFields.length()), "CURLOPT_POSTFIELDS");
         setOption(CURLOPT_COPYPOSTFIELDS, postFields.c_str(), "CURLOPT_POSTFIELDS");
         
     }
 
+    // GET, HEAD and POST use curl's own modes; any other verb goes out as a custom request, with `body` if given.
+    void setMethod(const std::string& method, const std::string& body = "") noexcept {
+        if (!body.empty() || method == "POST") setPostFields(body);
+        if (method == "GET") setGet(true);
+        else if (method == "HEAD") setOption(CURLOPT_NOBODY, 1L, "CURLOPT_NOBODY");
+        else if (!method.empty() && method != "POST") setOption(CURLOPT_CUSTOMREQUEST, method.c_str(), "CURLOPT_CUSTOMREQUEST");
+    }
+
     void setInterface(const std::string& inter) noexcept {
         setOption(CURLOPT_INTERFACE, inter.c_str(), "CURLOPT_INTERFACE");
     }
@@ -324,14 +486,32 @@ public:
 
     void setUrl(const std::string& url , const std::size_t d = 0) noexcept{
         buf.clear();
+        if (sink) sink->reset();
         depth = d;
+        request_url = url;
         setOption(CURLOPT_URL, url.c_str(), "CURLOPT_URL");
     }
 
-    const std::string& getBuffer() const noexcept{
+    // The URL as requested, before any redirect; Response::url holds the effective one.
+    const std::string& getUrl() const noexcept{
+        return request_url;
+    }
+
+    const ChunkChain& getBuffer() const noexcept{
         return buf;
     }
 
+    // Streams every body chunk through `s` as it arrives. With keep_body false the body is not buffered,
+    // so Response::message stays empty and the sink is the only consumer.
+    void setBodySink(std::unique_ptr<BodySink> s, const bool keep = true) noexcept{
+        sink = std::move(s);
+        keep_body = keep || !sink;
+    }
+
+    BodySink* getBodySink() const noexcept{
+        return sink.get();
+    }
+
     CURL* get() {
         return curl_handle_.get();
     }
@@ -340,6 +520,16 @@ public:
         return std::make_unique<Response>(get(),depth,buf);
     }
 
+    // Moves the body out instead of referencing it, leaving the handle free for the next transfer.
+    std::unique_ptr<Response> takeResponse() {
+        return std::make_unique<Response>(get(),depth,std::move(buf));
+    }
+
+    // This transfer's details around a body kept from an earlier one.
+    std::unique_ptr<Response> responseWith(ChunkChain&& body) {
+        return std::make_unique<Response>(get(),depth,std::move(body));
+    }
+
     CURLcode perform() noexcept {
         CURLcode res = curl_easy_perform(curl_handle_.get());
         return res;
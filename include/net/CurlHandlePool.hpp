@@ -2,36 +2,153 @@
 #define CURLHP
 
 #include <vector>
+#include <chrono>
+#include <functional>
 #include "CurlEasyHandle.hpp"
+#include "OptionProfile.hpp"
+#include "Request.hpp"
 
 
+// Idle easy handles, elastic between a low and a high watermark. Handles are created on demand up to the
+// high one, and handles above the low one are destroyed after sitting idle for a while.
+// The propagate* setters only reach idle handles; crawls should prefer OptionProfiles, which every handle
+// picks up on acquire.
 class CurlHandlePool {
 private:
     std::vector<std::unique_ptr<CurlEasyHandle>> pool;
+    std::vector<uint64_t> idle_since;
+    std::size_t min_sz;
     std::size_t max_sz;
-public:
-    CurlHandlePool(std::size_t initial_size , long buf_sz , long timeout) : max_sz(initial_size) {
-        pool.reserve(initial_size);
-        for (std::size_t i = 0; i < initial_size; ++i) {
-            pool.emplace_back(std::make_unique<CurlEasyHandle>(buf_sz , timeout));
+    std::size_t live {0};
+    std::size_t buf_sz;
+    long timeout;
+    uint64_t idle_ms {30000};
+    std::function<std::unique_ptr<BodySink>()> make_sink;
+    bool keep_body {true};
+    std::shared_ptr<CurlShare> share;
+
+    static uint64_t now() noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::unique_ptr<CurlEasyHandle> create() {
+        auto handle = std::make_unique<CurlEasyHandle>(buf_sz , timeout);
+        if (make_sink) handle->setBodySink(make_sink(), keep_body);
+        ++live;
+        return handle;
+    }
+
+    void grow(const std::size_t n) {
+        const uint64_t t = now();
+        while (live < n) {
+            pool.emplace_back(create());
+            idle_since.emplace_back(t);
         }
     }
 
+public:
+    CurlHandlePool(std::size_t initial_size , long buf_sz , long timeout) :
+        CurlHandlePool(initial_size, initial_size, buf_sz, timeout) {}
+
+    CurlHandlePool(std::size_t min_size , std::size_t max_size , long buf , long tm) :
+        min_sz(min_size), max_sz(max_size), buf_sz(buf), timeout(tm) {
+        if (max_sz == 0 || min_sz > max_sz) throw std::invalid_argument("Pool limits must satisfy 0 <= min <= max, max > 0");
+        pool.reserve(max_sz);
+        idle_since.reserve(max_sz);
+        grow(min_sz);
+    }
+
+    // No idle handle is waiting; acquire() may still create one, see canAcquire().
     const bool isEmpty() const noexcept {
         return pool.empty();
     }
 
+    const bool canAcquire() const noexcept {
+        return !pool.empty() || live < max_sz;
+    }
+
+    // Every handle the pool owns is back home.
     const bool isFull() const noexcept{
-        return pool.size() == max_sz;
+        return pool.size() == live;
+    }
+
+    const std::size_t size() const noexcept { return live; }
+    const std::size_t idleCount() const noexcept { return pool.size(); }
+    const std::size_t minSize() const noexcept { return min_sz; }
+    const std::size_t maxSize() const noexcept { return max_sz; }
+
+    void setLimits(const std::size_t min_size , const std::size_t max_size) {
+        if (max_size == 0 || min_size > max_size) throw std::invalid_argument("Pool limits must satisfy 0 <= min <= max, max > 0");
+        min_sz = min_size;
+        max_sz = max_size;
+        while (live > max_sz && !pool.empty()) {
+            pool.erase(pool.begin());
+            idle_since.erase(idle_since.begin());
+            --live;
+        }
+        grow(min_sz);
+    }
+
+    // How long a handle above the low watermark may sit idle before it is destroyed.
+    void setIdleTimeoutMs(const uint64_t ms) noexcept {
+        idle_ms = ms;
+    }
+
+    // Handles attach to `s` (or detach, for null) on their next acquire, and pick up its pins then.
+    void setShare(std::shared_ptr<CurlShare> s) noexcept {
+        share = std::move(s);
+    }
+
+    const std::shared_ptr<CurlShare>& getShare() const noexcept {
+        return share;
     }
 
     std::unique_ptr<CurlEasyHandle> acquire() {
+        std::unique_ptr<CurlEasyHandle> handle;
         if (isEmpty()) {
-            throw std::underflow_error("Pool is empty, cannot acquire handle");
+            if (live >= max_sz) throw std::underflow_error("Pool is empty, cannot acquire handle");
+            handle = create();
+        } else {
+            handle = std::move(pool.back());
+            pool.pop_back();
+            idle_since.pop_back();
         }
 
-        auto handle = std::move(pool.back());
-        pool.pop_back();
+        if (handle->getShare() != share.get()) handle->setShare(share);
+        auto pins = share ? share->resolveList() : nullptr;
+        if (pins.get() != handle->getResolveList()) handle->setResolveList(std::move(pins));
+        return handle;
+    }
+
+    // Acquires a handle set up with `profile`; options are re-applied only when the handle last ran a different one.
+    std::unique_ptr<CurlEasyHandle> acquire(const std::shared_ptr<const OptionProfile>& profile) {
+        auto handle = acquire();
+        if (handle->getProfile() != profile.get() || handle->isCustomized()) {
+            // A handle that never ran a profile still has its construction defaults.
+            if (handle->getProfile() || handle->isCustomized()) handle->resetOptions();
+            if (profile) profile->apply(*handle);
+            handle->setProfile(profile);
+        }
+        return handle;
+    }
+
+    // As above with the request's own profile (or `fallback`), then its per-request overrides on top, then
+    // `extra` headers (e.g. cache validators) after the profile's and the request's own.
+    std::unique_ptr<CurlEasyHandle> acquire(const Request& request, const std::shared_ptr<const OptionProfile>& fallback,
+                                            const std::vector<std::string>& extra_headers = {}) {
+        const auto& profile = request.profile ? request.profile : fallback;
+        auto handle = acquire(profile);
+        const RequestOverrides* extra = request.overrides();
+        if (extra) {
+            if (!extra->method.empty() || !extra->body.empty()) handle->setMethod(extra->method, extra->body);
+            if (extra->timeout_ms > 0) handle->setTimeoutMs(extra->timeout_ms);
+        }
+        if ((extra && !extra->headers.empty()) || !extra_headers.empty()) {
+            if (profile) handle->addHeaders(profile->getHeaders());
+            if (extra) handle->addHeaders(extra->headers);
+            handle->addHeaders(extra_headers);
+        }
+        if (extra || !extra_headers.empty()) handle->setCustomized(true);
         return handle;
     }
 
@@ -39,7 +156,24 @@ public:
         if (isFull()) {
             throw std::overflow_error("Pool is full, cannot release more handles");
         }
+        if (live > max_sz) {
+            --live;
+            return;
+        }
         pool.emplace_back(std::move(handle));
+        idle_since.emplace_back(now());
+    }
+
+    // Destroys handles above the low watermark that have been idle too long. The oldest idle ones sit at the front.
+    void shrink() {
+        if (live <= min_sz || pool.empty()) return;
+        const uint64_t t = now();
+        std::size_t n = 0;
+        while (n < pool.size() && live - n > min_sz && idle_since[n] + idle_ms <= t) ++n;
+        if (!n) return;
+        pool.erase(pool.begin(), pool.begin() + n);
+        idle_since.erase(idle_since.begin(), idle_since.begin() + n);
+        live -= n;
     }
 
     template<typename T>
@@ -70,6 +204,15 @@ public:
         }
     }
 
+    // Gives every handle its own sink, built by `make`, including handles created later.
+    void propagateBodySink(std::function<std::unique_ptr<BodySink>()> make, const bool keep = true) {
+        make_sink = std::move(make);
+        keep_body = keep;
+        for (auto& handle : pool) {
+            handle->setBodySink(make_sink ? make_sink() : nullptr, keep_body);
+        }
+    }
+
     void propogateClearHeaders() noexcept{
         for (auto& handle : pool) {
             handle->clearHeaders();
@@ -88,6 +231,12 @@ public:
         }
     }
 
+    void propagateMaxFileSize(const curl_off_t bytes) noexcept{
+        for (auto& handle : pool) {
+            handle->setMaxFileSize(bytes);
+        }
+    }
+
     void propogateAcceptEncoding(const std::string& val) noexcept{
         for (auto& handle : pool) {
             handle->setAcceptEncoding(val);
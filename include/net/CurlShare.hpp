@@ -0,0 +1,104 @@
+#ifndef CURLSHARE
+#define CURLSHARE
+
+#include <curl/curl.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+// A curl share handle: easy handles attached to it use one DNS cache and one TLS session cache, so a host
+// resolved or a session negotiated by one loop is reused by every other. Locking callbacks make it safe to
+// share between threads. Connections can be shared too, but curl does not support one connection cache
+// used from concurrent threads, so only do that for loops running on the same thread.
+// Pinned addresses (CURLOPT_RESOLVE) are handed to every attached handle and seed the shared DNS cache.
+class CurlShare {
+    // Declared before the handle: curl_share_cleanup still takes locks.
+    std::mutex locks[CURL_LOCK_DATA_LAST];
+    std::unique_ptr<CURLSH, decltype(&curl_share_cleanup)> share;
+    std::vector<std::string> pins;
+    std::shared_ptr<struct curl_slist> resolve_list;
+    mutable std::mutex pins_mtx;
+
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+        static_cast<CurlShare*>(userptr)->locks[data].lock();
+    }
+
+    static void unlock(CURL*, curl_lock_data data, void* userptr) {
+        static_cast<CurlShare*>(userptr)->locks[data].unlock();
+    }
+
+    template<typename T>
+    void setOption(const CURLSHoption option, const T value) {
+        if (const CURLSHcode res = curl_share_setopt(share.get(), option, value); res != CURLSHE_OK) {
+            throw std::runtime_error(std::string("Failed to set curl share option: ") + curl_share_strerror(res));
+        }
+    }
+
+    // Rebuilt on every change, so handles holding the previous list keep a valid one.
+    void buildResolveList() {
+        struct curl_slist* list = nullptr;
+        for (const auto& pin : pins) {
+            struct curl_slist* next = curl_slist_append(list, pin.c_str());
+            if (!next) {
+                curl_slist_free_all(list);
+                throw std::bad_alloc();
+            }
+            list = next;
+        }
+        resolve_list.reset(list, &curl_slist_free_all);
+    }
+
+public:
+    explicit CurlShare(const bool share_connections = false) : share(curl_share_init(), &curl_share_cleanup) {
+        if (!share) throw std::runtime_error("Failed to initialize curl share handle");
+        setOption(CURLSHOPT_USERDATA, static_cast<void*>(this));
+        setOption(CURLSHOPT_LOCKFUNC, lock);
+        setOption(CURLSHOPT_UNLOCKFUNC, unlock);
+        setOption(CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        setOption(CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        #if LIBCURL_VERSION_NUM >= 0x073900
+            if (share_connections) setOption(CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        #endif
+    }
+
+    CurlShare(const CurlShare&) = delete;
+    CurlShare& operator=(const CurlShare&) = delete;
+
+    CURLSH* get() const noexcept {
+        return share.get();
+    }
+
+    // Resolves `host`:`port` to `addresses` (IPv6 ones in brackets) without asking DNS, for every attached
+    // handle from its next transfer on. Pinning the same host and port again replaces the addresses.
+    void pin(const std::string& host, const int port, const std::vector<std::string>& addresses) {
+        if (host.empty() || addresses.empty()) throw std::invalid_argument("Pinning needs a host and at least one address");
+        const std::string key = host + ":" + std::to_string(port) + ":";
+        std::string entry = key;
+        for (std::size_t i = 0; i < addresses.size(); ++i) {
+            if (i) entry += ',';
+            entry += addresses[i];
+        }
+
+        std::lock_guard<std::mutex> guard(pins_mtx);
+        bool replaced = false;
+        for (auto& pin : pins) {
+            if (pin.compare(0, key.size(), key) == 0) {
+                pin = entry;
+                replaced = true;
+            }
+        }
+        if (!replaced) pins.emplace_back(std::move(entry));
+        buildResolveList();
+    }
+
+    // The current pins as a CURLOPT_RESOLVE list; null while nothing is pinned.
+    std::shared_ptr<struct curl_slist> resolveList() const {
+        std::lock_guard<std::mutex> guard(pins_mtx);
+        return resolve_list;
+    }
+};
+
+#endif
\ No newline at end of file
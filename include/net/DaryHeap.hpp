@@ -0,0 +1,78 @@
+#ifndef DARYHEAP
+#define DARYHEAP
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// Implicit D-ary max-heap in one contiguous vector. A wider fan-out makes the tree shallower and keeps each
+// node's children on one or two cache lines, which suits frontiers where pushes outnumber pops.
+// Before(a, b) is true when `a` must come out ahead of `b`.
+template<typename T, typename Before, std::size_t D = 4>
+class DaryHeap {
+    static_assert(D >= 2, "A heap needs a fan-out of at least 2");
+
+    std::vector<T> items;
+    Before before;
+
+    void siftUp(std::size_t i) {
+        T item = std::move(items[i]);
+        while (i > 0) {
+            const std::size_t parent = (i - 1) / D;
+            if (!before(item, items[parent])) break;
+            items[i] = std::move(items[parent]);
+            i = parent;
+        }
+        items[i] = std::move(item);
+    }
+
+    void siftDown(std::size_t i) {
+        const std::size_t n = items.size();
+        T item = std::move(items[i]);
+        for (;;) {
+            const std::size_t first = i * D + 1;
+            if (first >= n) break;
+            const std::size_t last = first + D < n ? first + D : n;
+            std::size_t best = first;
+            for (std::size_t c = first + 1; c < last; ++c) {
+                if (before(items[c], items[best])) best = c;
+            }
+            if (!before(items[best], item)) break;
+            items[i] = std::move(items[best]);
+            i = best;
+        }
+        items[i] = std::move(item);
+    }
+
+public:
+    explicit DaryHeap(Before b = Before()) : before(std::move(b)) {}
+
+    inline const bool empty() const noexcept { return items.empty(); }
+    inline const std::size_t size() const noexcept { return items.size(); }
+    inline const T& top() const noexcept { return items.front(); }
+
+    void reserve(const std::size_t n) { items.reserve(n); }
+    void clear() noexcept { items.clear(); }
+
+    void push(T item) {
+        items.emplace_back(std::move(item));
+        siftUp(items.size() - 1);
+    }
+
+    T pop() {
+        T out = std::move(items.front());
+        if (items.size() > 1) {
+            items.front() = std::move(items.back());
+            items.pop_back();
+            siftDown(0);
+        } else {
+            items.pop_back();
+        }
+        return out;
+    }
+
+    // Unordered view, e.g. for serialising the contents.
+    const std::vector<T>& data() const noexcept { return items; }
+};
+
+#endif
\ No newline at end of file
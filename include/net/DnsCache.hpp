@@ -0,0 +1,159 @@
+#ifndef DNSCACHE
+#define DNSCACHE
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <curl/curl.h>
+
+// Results of resolving hosts ahead of their requests: addresses for live hosts, a tombstone for hosts that do
+// not exist. Live hosts are handed to curl once per `seed_ms` as a CURLOPT_RESOLVE entry, which puts them in
+// its DNS cache before the request needs them; requests for dead hosts are dropped without a transfer.
+// Keyed by host name (no port). Safe to share between loops.
+class DnsCache {
+public:
+    enum class State { Unknown, Alive, Dead };
+
+private:
+    struct Host {
+        std::vector<std::string> addresses;
+        uint64_t expires {0};
+        uint64_t seeded_until {0};
+        bool resolving {false};
+    };
+
+    std::unordered_map<std::string, Host> hosts;
+    uint64_t ttl_ms;
+    uint64_t negative_ttl_ms;
+    uint64_t seed_ms;
+    uint64_t resolved {0};
+    uint64_t failed {0};
+    uint64_t dropped {0};
+    mutable std::mutex mtx;
+
+    static uint64_t now() noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    // `seed_ms` should stay below curl's own DNS cache timeout (60 s by default), or seeded entries age out early.
+    explicit DnsCache(const uint64_t ttl = 60000, const uint64_t negative_ttl = 300000, const uint64_t seed = 30000) :
+        ttl_ms(ttl), negative_ttl_ms(negative_ttl), seed_ms(seed) {}
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    // Splits `url` into the host name to resolve and the port to pin it for. False for IP literals, which need no lookup.
+    static const bool target(const std::string_view url, std::string& name, int& port) {
+        std::size_t begin = url.find("://");
+        const bool https = begin != std::string_view::npos && url.substr(0, begin) == "https";
+        begin = begin == std::string_view::npos ? 0 : begin + 3;
+        std::size_t end = url.find_first_of("/?#", begin);
+        if (end == std::string_view::npos) end = url.size();
+        const std::size_t at = url.rfind('@', end);
+        if (at != std::string_view::npos && at >= begin) begin = at + 1;
+        if (begin == end || url[begin] == '[') return false;
+
+        std::string_view authority = url.substr(begin, end - begin);
+        port = https ? 443 : 80;
+        if (const std::size_t colon = authority.rfind(':'); colon != std::string_view::npos) {
+            port = 0;
+            for (const char c : authority.substr(colon + 1)) {
+                if (c < '0' || c > '9') return false;
+                port = port * 10 + (c - '0');
+            }
+            authority = authority.substr(0, colon);
+        }
+        if (authority.find_first_not_of("0123456789.") == std::string_view::npos) return false;
+
+        name.assign(authority);
+        for (auto& c : name) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return true;
+    }
+
+    // True if `name` should be looked up now: it is neither known nor already being resolved by some loop.
+    const bool claim(const std::string& name) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto& host = hosts[name];
+        if (host.resolving || host.expires > now()) return false;
+        host.resolving = true;
+        return true;
+    }
+
+    void recordAddresses(const std::string& name, std::vector<std::string> addresses) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto& host = hosts[name];
+        host.addresses = std::move(addresses);
+        host.expires = now() + ttl_ms;
+        host.seeded_until = 0;
+        host.resolving = false;
+        ++resolved;
+    }
+
+    // The name does not exist; its requests are dropped for `negative_ttl` ms.
+    void recordMissing(const std::string& name) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto& host = hosts[name];
+        host.addresses.clear();
+        host.expires = now() + negative_ttl_ms;
+        host.resolving = false;
+        ++failed;
+    }
+
+    // The lookup failed in a way that says nothing about the host (timeout, cancelled): leave it to curl.
+    void forget(const std::string& name) {
+        std::lock_guard<std::mutex> guard(mtx);
+        hosts.erase(name);
+    }
+
+    // What is known about `name` for a request about to go out. For a live host not seeded recently, `seed`
+    // receives the CURLOPT_RESOLVE entry to hand to that request's handle.
+    State check(const std::string& name, const int port, std::string& seed) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = hosts.find(name);
+        const uint64_t t = now();
+        if (it == hosts.end() || it->second.resolving || it->second.expires <= t) return State::Unknown;
+        auto& host = it->second;
+        if (host.addresses.empty()) {
+            ++dropped;
+            return State::Dead;
+        }
+        if (host.seeded_until <= t) {
+            host.seeded_until = t + seed_ms;
+            // '+' lets the entry time out like a resolved one instead of staying for good.
+            #if LIBCURL_VERSION_NUM >= 0x074B00
+                seed = "+";
+            #endif
+            seed += name + ":" + std::to_string(port) + ":";
+            for (std::size_t i = 0; i < host.addresses.size(); ++i) {
+                if (i) seed += ',';
+                seed += host.addresses[i];
+            }
+        }
+        return State::Alive;
+    }
+
+    // Hosts resolved and found missing ahead of time, and requests dropped because their host was missing.
+    const uint64_t resolvedCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return resolved;
+    }
+
+    const uint64_t missingCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return failed;
+    }
+
+    const uint64_t droppedCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return dropped;
+    }
+};
+
+#endif
\ No newline at end of file
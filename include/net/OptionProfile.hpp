@@ -0,0 +1,119 @@
+#ifndef OPTIONPROFILE
+#define OPTIONPROFILE
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <new>
+
+#include "CurlEasyHandle.hpp"
+
+// An immutable-once-shared bundle of easy-handle options. Requests carry a shared_ptr to one, and a handle
+// re-applies options only when the profile it last applied is a different object, so the common case costs a
+// pointer compare. To change options, copy the profile, modify the copy, and share that.
+// Options are kept by key, so setting one again replaces it rather than stacking up.
+class OptionProfile {
+public:
+    using Op = std::function<void(CurlEasyHandle&)>;
+
+private:
+    std::vector<std::pair<std::string, Op>> ops;
+    std::vector<std::string> headers;
+    std::shared_ptr<struct curl_slist> header_list;
+
+    OptionProfile& set(const std::string& key, Op op) {
+        for (auto& entry : ops) {
+            if (entry.first == key) {
+                entry.second = std::move(op);
+                return *this;
+            }
+        }
+        ops.emplace_back(key, std::move(op));
+        return *this;
+    }
+
+    // Built once per profile and shared by every handle that applies it; curl only reads the list.
+    void buildHeaderList() {
+        struct curl_slist* list = nullptr;
+        for (const auto& header : headers) {
+            struct curl_slist* next = curl_slist_append(list, header.c_str());
+            if (!next) {
+                curl_slist_free_all(list);
+                throw std::bad_alloc();
+            }
+            list = next;
+        }
+        header_list.reset(list, &curl_slist_free_all);
+    }
+
+public:
+    OptionProfile() = default;
+    OptionProfile(const OptionProfile&) = default;
+    OptionProfile& operator=(const OptionProfile&) = default;
+
+    // Applied on top of a freshly reset handle.
+    void apply(CurlEasyHandle& handle) const {
+        for (const auto& entry : ops) entry.second(handle);
+        if (header_list) handle.useHeaderList(header_list.get());
+    }
+
+    // Any option not covered below; `key` identifies it so a later call replaces an earlier one.
+    OptionProfile& setCustom(const std::string& key, Op op) { return set("custom:" + key, std::move(op)); }
+
+    OptionProfile& addHeader(const std::string& header) {
+        headers.emplace_back(header);
+        buildHeaderList();
+        return *this;
+    }
+
+    OptionProfile& addHeaders(const std::vector<std::string>& hs) {
+        headers.insert(headers.end(), hs.begin(), hs.end());
+        buildHeaderList();
+        return *this;
+    }
+
+    OptionProfile& clearHeaders() noexcept {
+        headers.clear();
+        header_list.reset();
+        return *this;
+    }
+
+    const std::vector<std::string>& getHeaders() const noexcept { return headers; }
+
+    OptionProfile& setHttpVersion(const HTTP ver) { return set("httpversion", [ver](CurlEasyHandle& h){ h.setHTTPVersion(ver); }); }
+    OptionProfile& setMultiplexing(const bool val) { return set("pipewait", [val](CurlEasyHandle& h){ h.setMultiplexing(val); }); }
+    OptionProfile& setUserAgent(const std::string& ua) { return set("useragent", [ua](CurlEasyHandle& h){ h.setUserAgent(ua); }); }
+    OptionProfile& setMaxRedirections(const long l) { return set("maxredirs", [l](CurlEasyHandle& h){ h.setMaxRedirections(l); }); }
+    OptionProfile& setFollowRedirects(const bool f) { return set("followlocation", [f](CurlEasyHandle& h){ h.setFollowRedirects(f); }); }
+    OptionProfile& setReferer(const std::string& r) { return set("referer", [r](CurlEasyHandle& h){ h.setReferer(r); }); }
+    OptionProfile& setCookieFile(const std::string& f) { return set("cookiefile", [f](CurlEasyHandle& h){ h.setCookieFile(f); }); }
+    OptionProfile& setCookieJar(const std::string& f) { return set("cookiejar", [f](CurlEasyHandle& h){ h.setCookieJar(f); }); }
+    OptionProfile& setCookies(const std::string& c) { return set("cookie", [c](CurlEasyHandle& h){ h.setCookies(c); }); }
+    OptionProfile& setVerbose(const bool v) { return set("verbose", [v](CurlEasyHandle& h){ h.setVerbose(v); }); }
+    OptionProfile& setIPResolve(const long v) { return set("ipresolve", [v](CurlEasyHandle& h){ h.setIPResolve(v); }); }
+    OptionProfile& setInterface(const std::string& i) { return set("interface", [i](CurlEasyHandle& h){ h.setInterface(i); }); }
+    OptionProfile& setSSLUsage(const bool s) { return set("usessl", [s](CurlEasyHandle& h){ h.setSSLUsage(s); }); }
+    OptionProfile& setVerify(const bool v) { return set("verify", [v](CurlEasyHandle& h){ h.setVerify(v); }); }
+    OptionProfile& setAcceptEncoding(const std::string& e) { return set("encoding", [e](CurlEasyHandle& h){ h.setAcceptEncoding(e); }); }
+    OptionProfile& setBufferSize(const std::size_t sz) { return set("buffersize", [sz](CurlEasyHandle& h){ h.setBufferSize(sz); }); }
+    OptionProfile& setTimeoutMs(const long tm) { return set("timeout", [tm](CurlEasyHandle& h){ h.setTimeoutMs(tm); }); }
+    OptionProfile& setMaxFileSize(const curl_off_t b) { return set("maxfilesize", [b](CurlEasyHandle& h){ h.setMaxFileSize(b); }); }
+    OptionProfile& setLimitMBytesPerSec(const double m) { return set("maxrecvspeed", [m](CurlEasyHandle& h){ h.setLimitMBytesPerSec(m); }); }
+
+    OptionProfile& setGet(const bool val) { return set("method", [val](CurlEasyHandle& h){ h.setGet(val); }); }
+    OptionProfile& setPost(const bool val) { return set("method", [val](CurlEasyHandle& h){ h.setPost(val); }); }
+    OptionProfile& setMethod(const std::string& m, const std::string& body = "") { return set("method", [m, body](CurlEasyHandle& h){ h.setMethod(m, body); }); }
+    OptionProfile& setPostFields(const std::string& f) { return set("postfields", [f](CurlEasyHandle& h){ h.setPostFields(f); }); }
+
+    OptionProfile& setBearerToken(const std::string& t) { return set("auth", [t](CurlEasyHandle& h){ h.setBearerToken(t); }); }
+    OptionProfile& setBasicAuth(const std::string& u, const std::string& p) { return set("auth", [u, p](CurlEasyHandle& h){ h.setBasicAuth(u, p); }); }
+    OptionProfile& setDigestAuth(const std::string& u, const std::string& p) { return set("auth", [u, p](CurlEasyHandle& h){ h.setDigestAuth(u, p); }); }
+    OptionProfile& setNTLMAuth(const std::string& d, const std::string& u, const std::string& p) { return set("auth", [d, u, p](CurlEasyHandle& h){ h.setNTLMAuth(d, u, p); }); }
+    OptionProfile& setClientCertificate(const std::string& c, const std::string& k) { return set("sslcert", [c, k](CurlEasyHandle& h){ h.setClientCertificate(c, k); }); }
+
+    OptionProfile& setProxy(const std::string& url, const int port = 0) { return set("proxy", [url, port](CurlEasyHandle& h){ h.setProxy(url, port); }); }
+    OptionProfile& setProxyAuth(const std::string& u, const std::string& p) { return set("proxyauth", [u, p](CurlEasyHandle& h){ h.setProxyAuth(u, p); }); }
+};
+
+#endif
\ No newline at end of file
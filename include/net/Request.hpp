@@ -0,0 +1,77 @@
+#ifndef REQUEST
+#define REQUEST
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class OptionProfile;
+
+// Options that belong to one request rather than to the crawl; applied on top of the request's profile.
+struct RequestOverrides {
+    std::string method;
+    std::string body;
+    std::vector<std::string> headers;
+    long timeout_ms {0};
+};
+
+// One queued fetch. `profile` is the option snapshot it will be sent with; null means the defaults of
+// whichever loop picks it up. Per-request overrides sit behind a shared pointer, so a plain GET stays small
+// in the frontier and copies of a request share them until one is modified.
+class Request {
+    std::shared_ptr<RequestOverrides> overrides_;
+
+    RequestOverrides& edit() {
+        if (!overrides_) overrides_ = std::make_shared<RequestOverrides>();
+        else if (overrides_.use_count() > 1) overrides_ = std::make_shared<RequestOverrides>(*overrides_);
+        return *overrides_;
+    }
+
+public:
+    std::string url;
+    std::size_t depth {0};
+    std::shared_ptr<const OptionProfile> profile;
+    // Higher goes first among requests queued for the same host.
+    int priority {0};
+    // When false the request is queued even if the URL was seen before.
+    bool dedup {true};
+    // Retries so far; 0 for a first attempt.
+    uint32_t attempt {0};
+
+    Request() = default;
+    Request(std::string u, const std::size_t d = 0, std::shared_ptr<const OptionProfile> p = nullptr) :
+        url(std::move(u)), depth(d), profile(std::move(p)) {}
+
+    // "GET", "HEAD", "POST", or any other verb, sent as a custom request.
+    Request& setMethod(std::string method) { edit().method = std::move(method); return *this; }
+    Request& setBody(std::string body) { edit().body = std::move(body); return *this; }
+    Request& addHeader(std::string header) { edit().headers.emplace_back(std::move(header)); return *this; }
+    Request& setTimeoutMs(const long ms) { edit().timeout_ms = ms; return *this; }
+    Request& setPriority(const int p) noexcept { priority = p; return *this; }
+    Request& setDepth(const std::size_t d) noexcept { depth = d; return *this; }
+    Request& setDedup(const bool d) noexcept { dedup = d; return *this; }
+    Request& setProfile(std::shared_ptr<const OptionProfile> p) noexcept { profile = std::move(p); return *this; }
+
+    const RequestOverrides* overrides() const noexcept { return overrides_.get(); }
+
+    const std::string& method() const noexcept {
+        static const std::string none;
+        return overrides_ ? overrides_->method : none;
+    }
+
+    const std::string& body() const noexcept {
+        static const std::string none;
+        return overrides_ ? overrides_->body : none;
+    }
+
+    // Requests other than GET/HEAD are told apart by verb and body too, so two POSTs to one URL both go out.
+    const bool hasPayloadIdentity() const noexcept {
+        if (!overrides_) return false;
+        const auto& m = overrides_->method;
+        if (m.empty()) return !overrides_->body.empty();
+        return m != "GET" && m != "HEAD";
+    }
+};
+
+#endif
\ No newline at end of file
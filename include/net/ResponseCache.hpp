@@ -0,0 +1,301 @@
+#ifndef RESPCACHE
+#define RESPCACHE
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "BufferPool.hpp"
+#include "VisitedSet.hpp"
+
+// On-disk cache of GET responses keyed by canonical URL, kept for revalidation: a response with an ETag or
+// Last-Modified is stored with them, and the next fetch of the URL sends If-None-Match / If-Modified-Since.
+// Validators live in memory (replayed from index.log on open); bodies live one file per URL, spread over 256
+// subdirectories, and are only read back on a 304. Entries are written to a temporary file, synced and renamed into
+// place, so a crash leaves either the old entry or the new one; the header records the body's length, so an entry
+// cut short anyway is dropped rather than served. Safe to share between loops.
+class ResponseCache {
+public:
+    struct Entry {
+        std::string content_type;
+        ChunkChain body;
+    };
+
+private:
+    struct Validators {
+        std::string etag;
+        std::string last_modified;
+    };
+
+    static constexpr char magic[8] = {'H', 'P', 'S', 'C', 'A', 'C', 'H', '2'};
+
+    std::string dir;
+    std::unordered_map<uint64_t, Validators> index;
+    std::size_t index_records {0};
+    int index_fd {-1};
+    uint64_t hits {0};
+    uint64_t stores {0};
+    mutable std::mutex mtx;
+
+    static void putString(std::string& out, const std::string_view s) {
+        const uint32_t n = static_cast<uint32_t>(s.size());
+        out.append(reinterpret_cast<const char*>(&n), sizeof n);
+        out.append(s);
+    }
+
+    static bool getString(const char*& p, const char* end, std::string& s) {
+        uint32_t n;
+        if (static_cast<std::size_t>(end - p) < sizeof n) return false;
+        std::memcpy(&n, p, sizeof n);
+        p += sizeof n;
+        if (static_cast<std::size_t>(end - p) < n) return false;
+        s.assign(p, n);
+        p += n;
+        return true;
+    }
+
+    std::string entryPath(const uint64_t fp) const {
+        char name[32];
+        std::snprintf(name, sizeof name, "%02x/%016llx", static_cast<unsigned>(fp & 0xff), static_cast<unsigned long long>(fp));
+        return dir + "/" + name;
+    }
+
+    [[noreturn]] static void fail(const std::string& what, const std::string& file) {
+        throw std::runtime_error(what + " " + file + ": " + std::strerror(errno));
+    }
+
+    static bool writeAll(const int fd, const char* p, std::size_t n) {
+        while (n) {
+            const ssize_t w = ::write(fd, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+        return true;
+    }
+
+    // index.log: [fingerprint][etag][last-modified] records; the last one for a URL wins, both empty drops it.
+    // A failed append is cut off again so the records after it still load.
+    void appendIndex(const uint64_t fp, const Validators& v) {
+        std::string rec(reinterpret_cast<const char*>(&fp), sizeof fp);
+        putString(rec, v.etag);
+        putString(rec, v.last_modified);
+        const off_t before = ::lseek(index_fd, 0, SEEK_END);
+        if (!writeAll(index_fd, rec.data(), rec.size())) {
+            const int err = errno;
+            // Best effort: if this fails too, the next open stops reading at the torn record.
+            if (before >= 0) [[maybe_unused]] const int cut = ::ftruncate(index_fd, before);
+            errno = err;
+            fail("Cannot write", dir + "/index.log");
+        }
+        if (++index_records > 1024 && index_records > index.size() * 2) compactIndex();
+    }
+
+    void loadIndex() {
+        const std::string file = dir + "/index.log";
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT) return;
+            fail("Cannot open", file);
+        }
+        std::string data;
+        char buf[1 << 16];
+        for (ssize_t n; (n = ::read(fd, buf, sizeof buf)) != 0;) {
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                ::close(fd);
+                fail("Cannot read", file);
+            }
+            data.append(buf, static_cast<std::size_t>(n));
+        }
+        ::close(fd);
+
+        // A torn record at the end is what a crash mid-append leaves; everything before it is good.
+        const char* p = data.data();
+        const char* const end = p + data.size();
+        while (static_cast<std::size_t>(end - p) >= sizeof(uint64_t)) {
+            uint64_t fp;
+            std::memcpy(&fp, p, sizeof fp);
+            const char* q = p + sizeof fp;
+            Validators v;
+            if (!getString(q, end, v.etag) || !getString(q, end, v.last_modified)) break;
+            p = q;
+            ++index_records;
+            if (v.etag.empty() && v.last_modified.empty()) index.erase(fp);
+            else index[fp] = std::move(v);
+        }
+    }
+
+    void openIndex() {
+        const std::string file = dir + "/index.log";
+        index_fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+        if (index_fd < 0) fail("Cannot open", file);
+    }
+
+    void compactIndex() {
+        std::string data;
+        for (const auto& [fp, v] : index) {
+            data.append(reinterpret_cast<const char*>(&fp), sizeof fp);
+            putString(data, v.etag);
+            putString(data, v.last_modified);
+        }
+        const std::string tmp = dir + "/index.log.tmp";
+        const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) return;
+        const bool ok = writeAll(fd, data.data(), data.size()) && ::fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || ::rename(tmp.c_str(), (dir + "/index.log").c_str()) != 0) {
+            ::unlink(tmp.c_str());
+            return;
+        }
+        ::close(index_fd);
+        openIndex();
+        index_records = index.size();
+    }
+
+    void forget(const uint64_t fp) {
+        if (!index.erase(fp)) return;
+        appendIndex(fp, Validators{});
+        ::unlink(entryPath(fp).c_str());
+    }
+
+public:
+    explicit ResponseCache(std::string directory) : dir(std::move(directory)) {
+        if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) fail("Cannot create cache directory", dir);
+        for (unsigned i = 0; i < 256; ++i) {
+            char sub[8];
+            std::snprintf(sub, sizeof sub, "/%02x", i);
+            if (::mkdir((dir + sub).c_str(), 0700) != 0 && errno != EEXIST) fail("Cannot create cache directory", dir + sub);
+        }
+        loadIndex();
+        openIndex();
+    }
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    ~ResponseCache() {
+        if (index_fd >= 0) ::close(index_fd);
+    }
+
+    // Conditional request headers for `url`, if a response for it is cached.
+    void conditionalHeaders(const std::string& url, std::vector<std::string>& out) const {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = index.find(fingerprint64(url));
+        if (it == index.end()) return;
+        if (!it->second.etag.empty()) out.emplace_back("If-None-Match: " + it->second.etag);
+        if (!it->second.last_modified.empty()) out.emplace_back("If-Modified-Since: " + it->second.last_modified);
+    }
+
+    // Keeps `body` for `url` if it came with validators; without them any older entry is dropped.
+    void store(const std::string& url, const std::string& etag, const std::string& last_modified,
+               const std::string& content_type, const ChunkChain& body) {
+        const uint64_t fp = fingerprint64(url);
+        if (etag.empty() && last_modified.empty()) {
+            std::lock_guard<std::mutex> guard(mtx);
+            forget(fp);
+            return;
+        }
+
+        std::string head(magic, sizeof magic);
+        putString(head, url);
+        putString(head, content_type);
+        const uint64_t length = body.size();
+        head.append(reinterpret_cast<const char*>(&length), sizeof length);
+        const std::string file = entryPath(fp);
+        const std::string tmp = file + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) fail("Cannot create", tmp);
+        bool ok = writeAll(fd, head.data(), head.size());
+        for (auto it = body.begin(); ok && it != body.end(); ++it) ok = writeAll(fd, (*it).data(), (*it).size());
+        ok = ok && ::fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || ::rename(tmp.c_str(), file.c_str()) != 0) {
+            ::unlink(tmp.c_str());
+            fail("Cannot write", file);
+        }
+
+        std::lock_guard<std::mutex> guard(mtx);
+        Validators v {etag, last_modified};
+        appendIndex(fp, v);
+        index[fp] = std::move(v);
+        ++stores;
+    }
+
+    // The stored response for `url`, or nothing (and the entry forgotten) if it is missing or unreadable.
+    std::optional<Entry> load(const std::string& url) {
+        const uint64_t fp = fingerprint64(url);
+        const std::string file = entryPath(fp);
+        std::optional<Entry> entry;
+        const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            Entry e;
+            char buf[1 << 16];
+            uint64_t length = 0;
+            bool ok = true, header = false;
+            for (ssize_t n; ok && (n = ::read(fd, buf, sizeof buf)) != 0;) {
+                if (n < 0) {
+                    ok = errno == EINTR;
+                    continue;
+                }
+                const char* p = buf;
+                const char* const end = buf + n;
+                // The header sits in the first read; URLs longer than that are never stored by a real crawl.
+                if (!header) {
+                    std::string stored_url;
+                    ok = static_cast<std::size_t>(n) >= sizeof magic && std::memcmp(p, magic, sizeof magic) == 0;
+                    p += sizeof magic;
+                    ok = ok && getString(p, end, stored_url) && stored_url == url && getString(p, end, e.content_type)
+                            && static_cast<std::size_t>(end - p) >= sizeof length;
+                    if (ok) {
+                        std::memcpy(&length, p, sizeof length);
+                        p += sizeof length;
+                    }
+                    header = true;
+                }
+                if (ok) e.body.append(p, static_cast<std::size_t>(end - p));
+            }
+            ::close(fd);
+            if (ok && header && e.body.size() == length) entry = std::move(e);
+        }
+
+        std::lock_guard<std::mutex> guard(mtx);
+        if (entry) ++hits;
+        else forget(fp);
+        return entry;
+    }
+
+    const std::size_t size() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return index.size();
+    }
+
+    // Responses served from the cache after a 304, and responses stored.
+    const uint64_t hitCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return hits;
+    }
+
+    const uint64_t storeCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return stores;
+    }
+};
+
+#endif
\ No newline at end of file
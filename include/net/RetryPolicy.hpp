@@ -0,0 +1,141 @@
+#ifndef RETRYPOLICY
+#define RETRYPOLICY
+
+#include <string>
+#include <string_view>
+#include <mutex>
+#include <random>
+#include <ctime>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <curl/curl.h>
+
+// Failures worth another attempt, each with its own rule.
+enum class RetryClass { None, Connect, Timeout, Throttled, ServerError };
+
+// Up to `max_attempts` retries, the n-th waiting a random time in [0, min(max_ms, base_ms * 2^n)] ("full jitter",
+// so retries of one burst spread out instead of coming back together). A delay that would exceed `max_ms`
+// (a long Retry-After) means no retry.
+struct RetryRule {
+    uint32_t max_attempts {0};
+    uint64_t base_ms {1000};
+    uint64_t max_ms {30000};
+};
+
+// Decides whether and when a failed transfer is tried again. Retries draw on a budget: every first attempt
+// adds `ratio` of a token, every retry takes one, and at most `reserve` tokens are kept, so retries stay a
+// bounded share of the traffic however many transfers fail at once. Safe to share between loops.
+class RetryPolicy {
+    RetryRule rules[5];
+    double ratio;
+    double reserve;
+    double tokens;
+    uint64_t retried {0};
+    uint64_t refused {0};
+    std::mt19937_64 rng { std::random_device{}() };
+    mutable std::mutex mtx;
+
+    // Only requests that may safely run twice are retried after they could have reached the server.
+    static const bool idempotent(const std::string_view method) noexcept {
+        return method.empty() || method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS";
+    }
+
+public:
+    explicit RetryPolicy(const double budget_ratio = 0.1, const double budget_reserve = 10) :
+        ratio(budget_ratio), reserve(budget_reserve), tokens(budget_reserve) {
+        if (budget_ratio < 0 || budget_reserve < 1) throw std::invalid_argument("Retry budget needs ratio >= 0 and reserve >= 1");
+        rules[static_cast<int>(RetryClass::Connect)] = RetryRule{3, 500, 30000};
+        rules[static_cast<int>(RetryClass::Timeout)] = RetryRule{2, 1000, 30000};
+        rules[static_cast<int>(RetryClass::Throttled)] = RetryRule{5, 1000, 120000};
+        rules[static_cast<int>(RetryClass::ServerError)] = RetryRule{2, 1000, 30000};
+    }
+
+    RetryPolicy(const RetryPolicy&) = delete;
+    RetryPolicy& operator=(const RetryPolicy&) = delete;
+
+    // A rule with max_attempts 0 turns retries for that class off.
+    void setRule(const RetryClass c, const RetryRule rule) {
+        if (c == RetryClass::None) throw std::invalid_argument("Cannot set a retry rule for RetryClass::None");
+        std::lock_guard<std::mutex> guard(mtx);
+        rules[static_cast<int>(c)] = rule;
+    }
+
+    RetryRule rule(const RetryClass c) const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return rules[static_cast<int>(c)];
+    }
+
+    static RetryClass classify(const CURLcode result, const long response_code) noexcept {
+        switch (result) {
+            case CURLE_OK: break;
+            case CURLE_COULDNT_CONNECT:
+            case CURLE_SSL_CONNECT_ERROR:
+                return RetryClass::Connect;
+            case CURLE_OPERATION_TIMEDOUT:
+                return RetryClass::Timeout;
+            case CURLE_SEND_ERROR:
+            case CURLE_RECV_ERROR:
+            case CURLE_GOT_NOTHING:
+            case CURLE_PARTIAL_FILE:
+            case CURLE_HTTP2:
+            case CURLE_HTTP2_STREAM:
+                return RetryClass::ServerError;
+            default: return RetryClass::None;
+        }
+        if (response_code == 429 || response_code == 503) return RetryClass::Throttled;
+        if (response_code == 500 || response_code == 502 || response_code == 504) return RetryClass::ServerError;
+        return RetryClass::None;
+    }
+
+    // Retry-After as milliseconds from now: delay-seconds or an HTTP date. 0 when absent or unreadable.
+    static uint64_t parseRetryAfter(const std::string_view value) {
+        if (value.empty()) return 0;
+        if (value.find_first_not_of("0123456789") == std::string_view::npos) {
+            uint64_t seconds = 0;
+            for (const char c : value.substr(0, 9)) seconds = seconds * 10 + static_cast<uint64_t>(c - '0');
+            return seconds * 1000;
+        }
+        const time_t at = curl_getdate(std::string(value).c_str(), nullptr);
+        const time_t t = std::time(nullptr);
+        return at > t ? static_cast<uint64_t>(at - t) * 1000 : 0;
+    }
+
+    // Counts a first attempt towards the budget.
+    void deposit() {
+        std::lock_guard<std::mutex> guard(mtx);
+        tokens = std::min(reserve, tokens + ratio);
+    }
+
+    // The delay before retry number `attempt` (from 1) of a `c` failure, or -1 to give up: the class is not
+    // retried, its attempts are used up, the method is unsafe to repeat, the wait is too long, or the budget is spent.
+    int64_t delayMs(const RetryClass c, const uint32_t attempt, const std::string_view method, const uint64_t retry_after_ms = 0) {
+        if (c == RetryClass::None) return -1;
+        if (c != RetryClass::Connect && c != RetryClass::Throttled && !idempotent(method)) return -1;
+        std::lock_guard<std::mutex> guard(mtx);
+        const RetryRule& r = rules[static_cast<int>(c)];
+        if (attempt > r.max_attempts || retry_after_ms > r.max_ms) return -1;
+        if (tokens < 1) {
+            ++refused;
+            return -1;
+        }
+        tokens -= 1;
+        ++retried;
+        const uint64_t ceiling = std::min(r.max_ms, r.base_ms << std::min<uint32_t>(attempt - 1, 20));
+        const uint64_t backoff = std::uniform_int_distribution<uint64_t>(0, ceiling)(rng);
+        return static_cast<int64_t>(std::max(backoff, retry_after_ms));
+    }
+
+    // Retries scheduled, and failures not retried because the budget was spent.
+    const uint64_t retriedCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return retried;
+    }
+
+    const uint64_t refusedCount() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return refused;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,466 @@
+#ifndef SPILLSTORE
+#define SPILLSTORE
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Request.hpp"
+
+// A request on its way through the disk tier, with the rank the frontier gave it on arrival.
+struct SpilledRequest {
+    Request request;
+    double rank {0.0};
+    uint64_t tie {0};
+};
+
+// FIFO of requests kept in append-only segment files. The caller encodes records into an in-memory chunk;
+// full chunks go to a background thread that appends them to the open segment and seals it once it is
+// `segment_bytes` long. Reads come back a whole segment at a time: the thread maps the oldest sealed
+// segment, decodes it into a batch, deletes it and hints the kernel to read ahead the next one.
+// take() never waits for the disk; it returns an empty batch and `on_ready` fires once one has been loaded.
+// A loaded segment is handed out as many takes as the caller asks for, the rest staying here until then.
+// push() never waits either: past `max_chunks` encoded chunks the store is backlogged() and keeps queueing,
+// so memory is bounded by `max_chunks` chunks plus two decoded segments only while the caller heeds it.
+// Profiles can't be written out, so each distinct one is kept in a table and records carry its index.
+class SpillStore {
+    struct Segment {
+        std::string path;
+        std::size_t records {0};
+        std::size_t bytes {0};
+    };
+
+    struct Chunk {
+        std::string data;
+        std::size_t records {0};
+    };
+
+    std::string dir;
+    std::string prefix;
+    std::size_t segment_bytes;
+    std::size_t chunk_bytes;
+    std::size_t max_chunks;
+    std::function<void()> on_ready;
+
+    // Caller side; only touched under the frontier's own lock.
+    Chunk current;
+    std::vector<std::shared_ptr<const OptionProfile>> profiles;
+    std::unordered_map<const OptionProfile*, uint32_t> profile_ids;
+    std::vector<SpilledRequest> loaded;
+    std::size_t loaded_at {0};
+    std::size_t count {0};
+
+    // Shared with the I/O thread.
+    mutable std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable space_cv;
+    std::deque<Chunk> queued;
+    std::deque<Segment> sealed;
+    Segment open;
+    int open_fd {-1};
+    std::size_t next_segment {0};
+    std::size_t on_disk {0};
+    std::vector<SpilledRequest> batch;
+    std::vector<uint32_t> batch_profiles;
+    bool batch_ready {false};
+    bool want_batch {false};
+    bool stopping {false};
+    bool busy {false};
+    std::exception_ptr error;
+    std::thread worker;
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    static void putString(std::string& out, const std::string& s) {
+        putVarint(out, s.size());
+        out.append(s);
+    }
+
+    struct Reader {
+        const unsigned char* p;
+        const unsigned char* end;
+
+        uint64_t varint() {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (p == end) throw std::runtime_error("Truncated frontier segment");
+                const unsigned char b = *p++;
+                v |= static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            throw std::runtime_error("Corrupt frontier segment");
+        }
+
+        std::string string() {
+            const uint64_t n = varint();
+            if (n > static_cast<uint64_t>(end - p)) throw std::runtime_error("Truncated frontier segment");
+            std::string s(reinterpret_cast<const char*>(p), n);
+            p += n;
+            return s;
+        }
+    };
+
+    enum : unsigned char { HasOverrides = 1, NoDedup = 2 };
+
+    void encode(const SpilledRequest& item, const uint32_t profile_id) {
+        encodeRecord(current.data, item, profile_id);
+        ++current.records;
+    }
+
+    // Profile indices are resolved by the caller in take(), so the I/O thread never reads the table.
+    static void decode(const unsigned char* p, const std::size_t n, std::vector<SpilledRequest>& out, std::vector<uint32_t>& ids) {
+        const unsigned char* const end = p + n;
+        while (p != end) {
+            SpilledRequest item;
+            uint32_t id;
+            p = decodeRecord(p, end, item, id);
+            out.emplace_back(std::move(item));
+            ids.emplace_back(id);
+        }
+    }
+
+    static void writeAll(const int fd, const char* p, std::size_t n) {
+        while (n) {
+            const ssize_t w = ::write(fd, p, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("Cannot write frontier segment: " + std::string(std::strerror(errno)));
+            }
+            p += w;
+            n -= static_cast<std::size_t>(w);
+        }
+    }
+
+    void closeOpen() {
+        if (open_fd >= 0) ::close(open_fd);
+        open_fd = -1;
+    }
+
+    // Runs without the lock held.
+    void appendChunk(const Chunk& chunk) {
+        if (open_fd < 0) {
+            open.path = dir + "/" + prefix + std::to_string(next_segment++) + ".seg";
+            open_fd = ::open(open.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+            if (open_fd < 0) throw std::runtime_error("Cannot create frontier segment " + open.path + ": " + std::strerror(errno));
+        }
+        writeAll(open_fd, chunk.data.data(), chunk.data.size());
+    }
+
+    void seal() {
+        closeOpen();
+        sealed.emplace_back(std::move(open));
+        open = Segment{};
+    }
+
+    static void load(const Segment& segment, std::vector<SpilledRequest>& out, std::vector<uint32_t>& ids) {
+        out.reserve(segment.records);
+        ids.reserve(segment.records);
+        const int fd = ::open(segment.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("Cannot open frontier segment " + segment.path + ": " + std::strerror(errno));
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) != segment.bytes) {
+            ::close(fd);
+            throw std::runtime_error("Frontier segment " + segment.path + " has the wrong size");
+        }
+        if (segment.bytes) {
+            void* map = ::mmap(nullptr, segment.bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map frontier segment " + segment.path + ": " + std::strerror(errno));
+            }
+            ::madvise(map, segment.bytes, MADV_SEQUENTIAL);
+            try {
+                decode(static_cast<const unsigned char*>(map), segment.bytes, out, ids);
+            } catch (...) {
+                ::munmap(map, segment.bytes);
+                ::close(fd);
+                throw;
+            }
+            ::munmap(map, segment.bytes);
+        }
+        ::close(fd);
+        ::unlink(segment.path.c_str());
+    }
+
+    static void prefetch(const Segment& segment) {
+        const int fd = ::open(segment.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        ::close(fd);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(mtx);
+        while (true) {
+            work_cv.wait(guard, [this]{ return stopping || !queued.empty() || (want_batch && !batch_ready && on_disk); });
+            if (stopping) return;
+            try {
+                if (!queued.empty()) {
+                    Chunk chunk = std::move(queued.front());
+                    queued.pop_front();
+                    busy = true;
+                    guard.unlock();
+                    appendChunk(chunk);
+                    guard.lock();
+                    busy = false;
+                    space_cv.notify_all();
+                    open.records += chunk.records;
+                    open.bytes += chunk.data.size();
+                    if (open.bytes >= segment_bytes) seal();
+                    continue;
+                }
+
+                // Everything queued before the request has been written, so sealing the open segment keeps the order.
+                if (sealed.empty()) seal();
+                const Segment segment = sealed.front();
+                sealed.pop_front();
+                const Segment* next = sealed.empty() ? nullptr : &sealed.front();
+                const Segment ahead = next ? *next : Segment{};
+                busy = true;
+                guard.unlock();
+                std::vector<SpilledRequest> loaded;
+                std::vector<uint32_t> ids;
+                load(segment, loaded, ids);
+                if (!ahead.path.empty()) prefetch(ahead);
+                guard.lock();
+                busy = false;
+                space_cv.notify_all();
+                on_disk -= segment.records;
+                batch = std::move(loaded);
+                batch_profiles = std::move(ids);
+                batch_ready = true;
+                want_batch = false;
+            } catch (...) {
+                error = std::current_exception();
+                busy = false;
+                stopping = true;
+                space_cv.notify_all();
+            }
+            guard.unlock();
+            if (on_ready) on_ready();
+            guard.lock();
+        }
+    }
+
+    void rethrow() {
+        if (error) std::rethrow_exception(error);
+    }
+
+    // Hands the caller's chunk to the I/O thread. Runs under the frontier's lock, so it never waits for the disk.
+    void flush() {
+        if (!current.records) return;
+        std::lock_guard<std::mutex> guard(mtx);
+        rethrow();
+        on_disk += current.records;
+        queued.emplace_back(std::move(current));
+        current = Chunk{};
+        current.data.reserve(chunk_bytes);
+        work_cv.notify_one();
+    }
+
+    void removeFiles() {
+        closeOpen();
+        if (!open.path.empty()) ::unlink(open.path.c_str());
+        for (const auto& segment : sealed) ::unlink(segment.path.c_str());
+        open = Segment{};
+        sealed.clear();
+    }
+
+public:
+    // [len][flags][depth][priority][rank][tie][profile][url] then, with HasOverrides,
+    // [method][body][header count][headers...][timeout]. Integers are varints, priority zigzagged.
+    static void encodeRecord(std::string& out, const SpilledRequest& item, const uint32_t profile_id) {
+        thread_local std::string rec;
+        rec.clear();
+        const Request& r = item.request;
+        const RequestOverrides* extra = r.overrides();
+        rec.push_back(static_cast<char>((extra ? HasOverrides : 0) | (r.dedup ? 0 : NoDedup)));
+        putVarint(rec, r.depth);
+        putVarint(rec, (static_cast<uint64_t>(r.priority) << 1) ^ static_cast<uint64_t>(r.priority >> 31));
+        uint64_t rank;
+        std::memcpy(&rank, &item.rank, sizeof rank);
+        putVarint(rec, rank);
+        putVarint(rec, item.tie);
+        putVarint(rec, profile_id);
+        putString(rec, r.url);
+        if (extra) {
+            putString(rec, extra->method);
+            putString(rec, extra->body);
+            putVarint(rec, extra->headers.size());
+            for (const auto& h : extra->headers) putString(rec, h);
+            putVarint(rec, static_cast<uint64_t>(extra->timeout_ms));
+        }
+        putVarint(out, rec.size());
+        out.append(rec);
+    }
+
+    // Decodes the record at `p`, leaving the profile index in `profile_id`; returns where the next one starts.
+    static const unsigned char* decodeRecord(const unsigned char* p, const unsigned char* end, SpilledRequest& item, uint32_t& profile_id) {
+        Reader in {p, end};
+        const uint64_t len = in.varint();
+        if (len > static_cast<uint64_t>(in.end - in.p)) throw std::runtime_error("Truncated frontier segment");
+        Reader rec {in.p, in.p + len};
+
+        Request& r = item.request;
+        const unsigned char flags = rec.p != rec.end ? *rec.p++ : 0;
+        r.depth = rec.varint();
+        const uint64_t zz = rec.varint();
+        r.priority = static_cast<int>(static_cast<int64_t>(zz >> 1) ^ -static_cast<int64_t>(zz & 1));
+        const uint64_t rank = rec.varint();
+        std::memcpy(&item.rank, &rank, sizeof rank);
+        item.tie = rec.varint();
+        profile_id = static_cast<uint32_t>(rec.varint());
+        r.url = rec.string();
+        r.dedup = !(flags & NoDedup);
+        if (flags & HasOverrides) {
+            std::string method = rec.string();
+            std::string body = rec.string();
+            if (!method.empty()) r.setMethod(std::move(method));
+            if (!body.empty()) r.setBody(std::move(body));
+            for (uint64_t h = rec.varint(); h; --h) r.addHeader(rec.string());
+            const long timeout = static_cast<long>(rec.varint());
+            if (timeout) r.setTimeoutMs(timeout);
+        }
+        return in.p + len;
+    }
+
+    explicit SpillStore(std::string directory , const std::size_t seg_bytes = 64u << 20 ,
+                        const std::size_t chunk = 1u << 20 , const std::size_t chunks = 4) :
+        dir(std::move(directory)), segment_bytes(seg_bytes), chunk_bytes(std::min(chunk, seg_bytes)), max_chunks(chunks ? chunks : 1) {
+        struct stat st {};
+        if (::stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) throw std::invalid_argument("Spill directory does not exist: " + dir);
+        prefix = "frontier-" + std::to_string(::getpid()) + "-" + std::to_string(reinterpret_cast<uintptr_t>(this)) + "-";
+        current.data.reserve(chunk_bytes);
+        worker = std::thread([this]{ run(); });
+    }
+
+    SpillStore(const SpillStore&) = delete;
+    SpillStore& operator=(const SpillStore&) = delete;
+
+    ~SpillStore() {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            stopping = true;
+        }
+        work_cv.notify_all();
+        if (worker.joinable()) worker.join();
+        removeFiles();
+    }
+
+    // Called from the I/O thread each time a batch is ready to take.
+    void onReady(std::function<void()> fn) {
+        on_ready = std::move(fn);
+    }
+
+    void push(const SpilledRequest& item) {
+        uint32_t profile_id = 0;
+        if (const OptionProfile* p = item.request.profile.get()) {
+            auto it = profile_ids.find(p);
+            if (it == profile_ids.end()) {
+                profiles.emplace_back(item.request.profile);
+                it = profile_ids.emplace(p, static_cast<uint32_t>(profiles.size())).first;
+            }
+            profile_id = it->second;
+        }
+        encode(item, profile_id);
+        ++count;
+        if (current.data.size() >= chunk_bytes) flush();
+    }
+
+    // Up to `max` of the oldest requests, in arrival order; empty when the next batch is still on its way from disk.
+    std::vector<SpilledRequest> take(const std::size_t max = SIZE_MAX) {
+        if (loaded_at == loaded.size()) {
+            loaded.clear();
+            loaded_at = 0;
+            std::vector<uint32_t> ids;
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                rethrow();
+                if (batch_ready) {
+                    loaded.swap(batch);
+                    ids.swap(batch_profiles);
+                    batch_ready = false;
+                } else if (!on_disk) {
+                    // Nothing older is on disk, so the unflushed chunk is next and never needs to touch it.
+                    if (current.records) decode(reinterpret_cast<const unsigned char*>(current.data.data()), current.data.size(), loaded, ids);
+                    current.data.clear();
+                    current.records = 0;
+                }
+                if (on_disk && !batch_ready && !want_batch) {
+                    want_batch = true;
+                    work_cv.notify_one();
+                }
+            }
+            for (std::size_t i = 0; i < loaded.size(); ++i) {
+                if (!ids[i]) continue;
+                if (ids[i] > profiles.size()) throw std::runtime_error("Corrupt frontier segment");
+                loaded[i].request.profile = profiles[ids[i] - 1];
+            }
+        }
+        std::vector<SpilledRequest> out;
+        const std::size_t n = std::min(max, loaded.size() - loaded_at);
+        if (!loaded_at && n == loaded.size()) {
+            out.swap(loaded);
+        } else {
+            out.reserve(n);
+            std::move(loaded.begin() + loaded_at, loaded.begin() + loaded_at + n, std::back_inserter(out));
+            loaded_at += n;
+        }
+        count -= out.size();
+        return out;
+    }
+
+    // True while `max_chunks` or more encoded chunks wait for the I/O thread; pushes still succeed.
+    const bool backlogged() const {
+        std::lock_guard<std::mutex> guard(mtx);
+        return queued.size() >= max_chunks;
+    }
+
+    void clear() {
+        std::unique_lock<std::mutex> guard(mtx);
+        // Let the thread finish what it is writing or loading before deleting the files under it.
+        want_batch = false;
+        space_cv.wait(guard, [this]{ return (queued.empty() && !busy) || error; });
+        removeFiles();
+        batch.clear();
+        batch_profiles.clear();
+        batch_ready = false;
+        want_batch = false;
+        on_disk = 0;
+        current = Chunk{};
+        loaded.clear();
+        loaded_at = 0;
+        count = 0;
+        profiles.clear();
+        profile_ids.clear();
+    }
+
+    inline const std::size_t size() const noexcept { return count; }
+    inline const bool empty() const noexcept { return count == 0; }
+};
+
+#endif
\ No newline at end of file
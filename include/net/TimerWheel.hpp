@@ -0,0 +1,242 @@
+#ifndef TIMERWHEEL
+#define TIMERWHEEL
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+// Hierarchical timer wheel over millisecond ticks: four levels of 256 slots, level L holding entries due in a
+// later slot of the current 256^(L+1) ms block. Insert and cancel are O(1); an entry moves down a level at most
+// three times before it fires, and runs of empty slots are skipped whole, so advancing costs the entries that
+// fire plus one step per occupied slot. Deadlines beyond the 2^32 ms horizon wait in an overflow list.
+// Entries live in one slab and are chained through it, so scheduling allocates only when the slab grows.
+// Not synchronised internally.
+template<typename T>
+class TimerWheel {
+public:
+    // Never 0, so 0 can stand for "no timer".
+    using Id = uint64_t;
+
+private:
+    static constexpr unsigned bits = 8;
+    static constexpr unsigned slots = 1u << bits;
+    static constexpr unsigned levels = 4;
+    static constexpr uint64_t mask = slots - 1;
+    static constexpr uint32_t nil = std::numeric_limits<uint32_t>::max();
+    // Bucket values beyond the wheel's own: free, in the overflow list, or detached while firing.
+    static constexpr uint32_t unused = nil, overflowing = nil - 1, detached = nil - 2;
+
+    struct Node {
+        uint64_t due {0};
+        T value {};
+        uint32_t prev {nil};
+        uint32_t next {nil};
+        uint32_t gen {1};
+        uint32_t bucket {unused};
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> free_nodes;
+    std::vector<uint32_t> heads = std::vector<uint32_t>(levels * slots, nil);
+    uint64_t occupied[levels][slots / 64] {};
+    std::vector<uint32_t> overflow;
+    std::vector<std::pair<uint32_t, uint32_t>> firing;
+    uint64_t cur;
+    std::size_t count {0};
+
+    inline void setBit(const unsigned level, const unsigned slot) noexcept { occupied[level][slot >> 6] |= 1ull << (slot & 63); }
+    inline void clearBit(const unsigned level, const unsigned slot) noexcept { occupied[level][slot >> 6] &= ~(1ull << (slot & 63)); }
+
+    // First occupied slot at `level` from `from` on, or -1.
+    int findSet(const unsigned level, const unsigned from) const noexcept {
+        for (unsigned word = from >> 6; word < slots / 64; ++word) {
+            uint64_t w = occupied[level][word];
+            if (word == from >> 6) w &= ~0ull << (from & 63);
+            if (w) return static_cast<int>(word * 64 + static_cast<unsigned>(__builtin_ctzll(w)));
+        }
+        return -1;
+    }
+
+    void link(const uint32_t i, const uint32_t bucket) {
+        Node& node = nodes[i];
+        node.bucket = bucket;
+        node.prev = nil;
+        node.next = heads[bucket];
+        if (node.next != nil) nodes[node.next].prev = i;
+        heads[bucket] = i;
+        setBit(bucket / slots, bucket % slots);
+    }
+
+    void unlink(const uint32_t i) {
+        Node& node = nodes[i];
+        if (node.bucket == overflowing) {
+            overflow.erase(std::find(overflow.begin(), overflow.end(), i));
+        } else if (node.bucket < levels * slots) {
+            if (node.prev != nil) nodes[node.prev].next = node.next;
+            else heads[node.bucket] = node.next;
+            if (node.next != nil) nodes[node.next].prev = node.prev;
+            if (heads[node.bucket] == nil) clearBit(node.bucket / slots, node.bucket % slots);
+        }
+        node.bucket = detached;
+    }
+
+    // Files an entry by where its deadline first differs from the next tick to be processed.
+    void place(const uint32_t i) {
+        const uint64_t ref = cur + 1;
+        const uint64_t due = std::max(nodes[i].due, ref);
+        const uint64_t diff = due ^ ref;
+        if (diff >> (bits * levels)) {
+            nodes[i].bucket = overflowing;
+            overflow.emplace_back(i);
+            return;
+        }
+        unsigned level = 0;
+        while (level + 1 < levels && (diff >> (bits * (level + 1)))) ++level;
+        link(i, level * slots + static_cast<uint32_t>((due >> (bits * level)) & mask));
+    }
+
+    void release(const uint32_t i) {
+        Node& node = nodes[i];
+        node.value = T{};
+        node.bucket = unused;
+        ++node.gen;
+        if (!node.gen) node.gen = 1;
+        free_nodes.emplace_back(i);
+        --count;
+    }
+
+    // Takes a bucket's entries off the wheel, oldest first.
+    void detach(const uint32_t bucket) {
+        firing.clear();
+        for (uint32_t i = heads[bucket]; i != nil; i = nodes[i].next) {
+            nodes[i].bucket = detached;
+            firing.emplace_back(i, nodes[i].gen);
+        }
+        std::reverse(firing.begin(), firing.end());
+        heads[bucket] = nil;
+        clearBit(bucket / slots, bucket % slots);
+    }
+
+    // Entering a new block at `next`: every level whose index just changed hands its slot down, highest first.
+    void cascade(const uint64_t next) {
+        unsigned top = 1;
+        while (top + 1 < levels && !(next & ((1ull << (bits * (top + 1))) - 1))) ++top;
+        if (top == levels - 1 && !(next & ((1ull << (bits * levels)) - 1)) && !overflow.empty()) {
+            std::vector<uint32_t> waiting;
+            waiting.swap(overflow);
+            for (const uint32_t i : waiting) place(i);
+        }
+        for (unsigned level = top; level >= 1; --level) {
+            const uint32_t bucket = level * slots + static_cast<uint32_t>((next >> (bits * level)) & mask);
+            if (heads[bucket] == nil) continue;
+            detach(bucket);
+            for (const auto& [i, gen] : firing) place(i);
+        }
+    }
+
+    // A lower bound on the earliest deadline at or after `ref`, exact when it is in the current 256 ms block.
+    uint64_t earliest(const uint64_t ref) const noexcept {
+        // At a block start, the slots being entered have not been cascaded yet.
+        for (unsigned level = 1; level <= levels && !(ref & ((1ull << (bits * level)) - 1)); ++level) {
+            if (level == levels ? !overflow.empty() : heads[level * slots + ((ref >> (bits * level)) & mask)] != nil) return ref;
+        }
+        if (const int s = findSet(0, static_cast<unsigned>(ref & mask)); s >= 0) return (ref & ~mask) | static_cast<uint64_t>(s);
+        for (unsigned level = 1; level < levels; ++level) {
+            const unsigned shift = bits * level;
+            const int s = findSet(level, static_cast<unsigned>((ref >> shift) & mask));
+            if (s < 0) continue;
+            const uint64_t start = ((ref >> (shift + bits)) << (shift + bits)) | (static_cast<uint64_t>(s) << shift);
+            return std::max(start, ref);
+        }
+        if (!overflow.empty()) return ((ref >> (bits * levels)) + 1) << (bits * levels);
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+public:
+    // `now` is the current time in ms; deadlines are on the same clock.
+    explicit TimerWheel(const uint64_t now = 0) : cur(now) {}
+
+    // Schedules `value` for `due`. A deadline not after the time last advanced to counts as due one tick later.
+    Id insert(const uint64_t due, T value) {
+        uint32_t i;
+        if (!free_nodes.empty()) {
+            i = free_nodes.back();
+            free_nodes.pop_back();
+        } else {
+            i = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[i].due = due;
+        nodes[i].value = std::move(value);
+        ++count;
+        place(i);
+        return (static_cast<Id>(nodes[i].gen) << 32) | i;
+    }
+
+    // False if the timer already fired or was cancelled.
+    const bool cancel(const Id id) {
+        const uint32_t i = static_cast<uint32_t>(id);
+        if (i >= nodes.size() || nodes[i].gen != static_cast<uint32_t>(id >> 32) || nodes[i].bucket == unused) return false;
+        unlink(i);
+        release(i);
+        return true;
+    }
+
+    // Moves time on to `now` and hands `fire` every value due by then, in deadline order. `fire` may insert
+    // or cancel timers, but not advance the wheel.
+    template<typename Fire>
+    void advance(const uint64_t now, Fire&& fire) {
+        std::vector<std::pair<uint32_t, uint32_t>> batch;
+        while (cur < now) {
+            const uint64_t next = cur + 1;
+            if (!(next & mask)) cascade(next);
+            const uint64_t at = earliest(next);
+            if (at > now) {
+                cur = now;
+                break;
+            }
+            if (at > next) {
+                cur = at - 1;
+                continue;
+            }
+            cur = next;
+            const uint32_t bucket = static_cast<uint32_t>(next & mask);
+            if (heads[bucket] == nil) continue;
+            detach(bucket);
+            batch.swap(firing);
+            for (const auto& [i, gen] : batch) {
+                // Cancelled by an earlier callback in this batch.
+                if (nodes[i].gen != gen || nodes[i].bucket != detached) continue;
+                T value = std::move(nodes[i].value);
+                release(i);
+                fire(std::move(value));
+            }
+            batch.swap(firing);
+        }
+    }
+
+    // Milliseconds from `now` until the next timer may be due (a lower bound for ones more than 256 ms out),
+    // or -1 when none is scheduled.
+    const int64_t msUntilNext(const uint64_t now) const noexcept {
+        if (!count) return -1;
+        const uint64_t at = earliest(cur + 1);
+        return at > now ? static_cast<int64_t>(at - now) : 0;
+    }
+
+    void clear() noexcept {
+        nodes.clear();
+        free_nodes.clear();
+        std::fill(heads.begin(), heads.end(), nil);
+        for (auto& level : occupied) std::fill(std::begin(level), std::end(level), 0);
+        overflow.clear();
+        count = 0;
+    }
+
+    inline const std::size_t size() const noexcept { return count; }
+    inline const bool empty() const noexcept { return count == 0; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+#ifndef URLCANON
+#define URLCANON
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+// Rewrites absolute URLs into one canonical spelling before dedup: lower-case scheme and host, no default port,
+// no fragment, dot segments resolved, upper-case percent escapes, and optionally a filtered and sorted query.
+// The canonical form is never longer than the input plus a '/', so it is written in one pass into a reused buffer.
+class URLCanonicalizer {
+    bool sort_query {false};
+    std::vector<std::string> stripped_params;
+    std::string out;
+    std::vector<std::string_view> params;
+
+    static inline char lower(const char c) noexcept {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static inline char upper(const char c) noexcept {
+        return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+
+    static inline bool isHex(const char c) noexcept {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    static inline bool isSchemeChar(const char c) noexcept {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.';
+    }
+
+    static inline bool isDefaultPort(const std::string_view scheme, const std::string_view port) noexcept {
+        return port.empty() || (port == "80" && scheme == "http") || (port == "443" && scheme == "https");
+    }
+
+    static char* copyEscaped(char* w, const char* s, const char* end) noexcept {
+        while (s < end) {
+            const char c = *s++;
+            *w++ = c;
+            if (c == '%' && end - s >= 2 && isHex(s[0]) && isHex(s[1])) {
+                *w++ = upper(*s++);
+                *w++ = upper(*s++);
+            }
+        }
+        return w;
+    }
+
+    // RFC 3986 5.2.4 on a path that starts with '/'; `base` is where the path begins in the output.
+    static char* copyPath(char* const base, const char* s, const char* const end) noexcept {
+        char* w = base;
+        while (s < end) {
+            const char* seg = ++s;
+            while (s < end && *s != '/') ++s;
+            const std::size_t len = static_cast<std::size_t>(s - seg);
+            const bool last = s == end;
+
+            if (len == 1 && seg[0] == '.') {
+                if (last) *w++ = '/';
+            } else if (len == 2 && seg[0] == '.' && seg[1] == '.') {
+                while (w > base && *--w != '/') {}
+                if (last) *w++ = '/';
+            } else {
+                *w++ = '/';
+                w = copyEscaped(w, seg, s);
+            }
+        }
+        if (w == base) *w++ = '/';
+        return w;
+    }
+
+    const bool isStripped(const std::string_view key) const noexcept {
+        for (const auto& p : stripped_params) {
+            if (!p.empty() && p.back() == '*') {
+                if (key.substr(0, p.size() - 1) == std::string_view(p).substr(0, p.size() - 1)) return true;
+            } else if (key == p) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    char* copyQuery(char* w, const std::string_view query) {
+        if (query.empty()) return w;
+        if (!sort_query && stripped_params.empty()) {
+            *w++ = '?';
+            return copyEscaped(w, query.data(), query.data() + query.size());
+        }
+
+        params.clear();
+        std::size_t pos = 0;
+        while (pos <= query.size()) {
+            std::size_t end = query.find('&', pos);
+            if (end == std::string_view::npos) end = query.size();
+            const std::string_view param = query.substr(pos, end - pos);
+            if (!param.empty() && !isStripped(param.substr(0, param.find('=')))) params.emplace_back(param);
+            pos = end + 1;
+        }
+        if (params.empty()) return w;
+        if (sort_query) std::sort(params.begin(), params.end());
+
+        *w++ = '?';
+        for (std::size_t i = 0; i < params.size(); ++i) {
+            if (i) *w++ = '&';
+            w = copyEscaped(w, params[i].data(), params[i].data() + params[i].size());
+        }
+        return w;
+    }
+
+public:
+    void setSortQuery(const bool val) noexcept {
+        sort_query = val;
+    }
+
+    // Query keys to drop; a trailing '*' matches by prefix, e.g. "utm_*".
+    void setStrippedParams(std::vector<std::string> keys) {
+        stripped_params = std::move(keys);
+    }
+
+    // Anything that is not "scheme://..." (relative links, mailto:, javascript:) comes back unchanged.
+    // The returned view is only valid until the next call.
+    std::string_view canonicalize(std::string_view url) {
+        while (!url.empty() && static_cast<unsigned char>(url.front()) <= ' ') url.remove_prefix(1);
+        while (!url.empty() && static_cast<unsigned char>(url.back()) <= ' ') url.remove_suffix(1);
+
+        std::size_t colon = 0;
+        while (colon < url.size() && isSchemeChar(url[colon])) ++colon;
+        if (colon == 0 || url.size() < colon + 3 || url[colon] != ':' || url[colon + 1] != '/' || url[colon + 2] != '/') return url;
+
+        if (out.size() < url.size() + 1) out.resize(url.size() + 1);
+        char* const begin = &out[0];
+        char* w = begin;
+
+        for (std::size_t i = 0; i < colon; ++i) *w++ = lower(url[i]);
+        const std::string_view scheme(begin, colon);
+        std::memcpy(w, "://", 3);
+        w += 3;
+
+        // One pass over the authority, remembering the last '@' and the last ':' outside an IPv6 literal.
+        const std::size_t auth_begin = colon + 3;
+        std::size_t auth_end = auth_begin, at = std::string_view::npos, port_colon = std::string_view::npos;
+        for (; auth_end < url.size(); ++auth_end) {
+            const char c = url[auth_end];
+            if (c == '/' || c == '?' || c == '#') break;
+            if (c == '@') {
+                at = auth_end;
+                port_colon = std::string_view::npos;
+            } else if (c == ':') {
+                port_colon = auth_end;
+            } else if (c == ']') {
+                port_colon = std::string_view::npos;
+            }
+        }
+
+        std::size_t host_begin = auth_begin;
+        if (at != std::string_view::npos) {
+            std::memcpy(w, url.data() + auth_begin, at + 1 - auth_begin);
+            w += at + 1 - auth_begin;
+            host_begin = at + 1;
+        }
+        std::size_t host_end = port_colon != std::string_view::npos ? port_colon : auth_end;
+        if (host_end > host_begin && url[host_end - 1] == '.') --host_end;
+        for (std::size_t i = host_begin; i < host_end; ++i) *w++ = lower(url[i]);
+
+        if (port_colon != std::string_view::npos) {
+            const std::string_view port = url.substr(port_colon + 1, auth_end - port_colon - 1);
+            if (!isDefaultPort(scheme, port)) {
+                *w++ = ':';
+                std::memcpy(w, port.data(), port.size());
+                w += port.size();
+            }
+        }
+
+        std::size_t path_end = auth_end;
+        while (path_end < url.size() && url[path_end] != '?' && url[path_end] != '#') ++path_end;
+        w = copyPath(w, url.data() + auth_end, url.data() + path_end);
+
+        if (path_end < url.size() && url[path_end] == '?') {
+            std::size_t query_end = path_end + 1;
+            while (query_end < url.size() && url[query_end] != '#') ++query_end;
+            w = copyQuery(w, url.substr(path_end + 1, query_end - path_end - 1));
+        }
+
+        return std::string_view(begin, static_cast<std::size_t>(w - begin));
+    }
+};
+
+#endif
\ No newline at end of file
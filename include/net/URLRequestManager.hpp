@@ -2,49 +2,685 @@
 #define URLRM
 
 #include <deque>
+#include <vector>
+#include <unordered_map>
 #include <unordered_set>
+#include <memory>
+#include <string_view>
+#include <chrono>
+#include <functional>
+#include <limits>
 #include <iostream>
+#include <mutex>
+#include <algorithm>
 
+#include "VisitedSet.hpp"
+#include "URLCanonicalizer.hpp"
+#include "Request.hpp"
+#include "DaryHeap.hpp"
+#include "TimerWheel.hpp"
+#include "SpillStore.hpp"
+#include "Checkpoint.hpp"
+
+// How the frontier picks the next URL. RoundRobin keeps each host FIFO and lets hosts take turns; the others
+// order the whole frontier (ties between hosts included) and only fall back to politeness for who may go now.
+enum class FrontierOrder { RoundRobin, BreadthFirst, DepthFirst, BestFirst };
+
+// What a best-first score function gets to see about a discovered URL.
+struct ScoreContext {
+    std::string_view url;
+    std::string_view host;
+    std::string_view anchor;
+    std::size_t depth;
+    int priority;
+};
+
+// Frontier split into one queue per host. Hosts whose crawl delay has passed and that are below their in-flight
+// cap are "ready"; the rest wait on a timer wheel for the time they become ready again. Each host's queue is a
+// 4-ary heap ordered by (priority, rank, arrival), and ready hosts are picked by their best entry, or round-robin.
+// With a spill directory set, only `hot_limit` requests live in the host queues; later arrivals go to a
+// SpillStore on disk and come back in arrival order as the hot tier drains, so ranking is exact within it.
+// Not synchronised internally: callers that share one manager between loops hold lock() around every call.
 class URLRequestManager {
-    std::deque<std::pair<std::string, size_t>> url_queue;
-    std::unordered_set<std::string> visited_urls;
+public:
+    using ScoreFunction = std::function<double(const ScoreContext&)>;
+
+    // A request's place in the order: higher priority first, then higher rank, then higher tie (FIFO or LIFO,
+    // depending on the order). popURL hands it out so that a retry can queue the request in the same place.
+    struct Key {
+        int priority;
+        double rank;
+        uint64_t tie;
+    };
+
+private:
+
+    static bool ahead(const Key& a, const Key& b) noexcept {
+        if (a.priority != b.priority) return a.priority > b.priority;
+        if (a.rank != b.rank) return a.rank > b.rank;
+        return a.tie > b.tie;
+    }
+
+    struct Entry {
+        Key key;
+        uint32_t slot;
+    };
+
+    struct EntryBefore {
+        bool operator()(const Entry& a, const Entry& b) const noexcept { return ahead(a.key, b.key); }
+    };
+
+    // Requests stay put in `slots`; only the small entries move while the heap reorders.
+    struct HostQueue {
+        std::string name;
+        DaryHeap<Entry, EntryBefore> heap;
+        std::vector<Request> slots;
+        std::vector<uint32_t> free_slots;
+        uint64_t ready_at {0};
+        std::size_t in_flight {0};
+        std::size_t limit {0};
+        std::size_t accepted {0};
+        uint64_t version {0};
+        bool scheduled {false};
+        bool ready {false};
+
+        inline const bool empty() const noexcept { return heap.empty(); }
+    };
+
+    // A ready host as it looked when queued; stale once the host's version has moved on.
+    struct ReadyHost {
+        Key key;
+        HostQueue* host;
+        uint64_t version;
+    };
+
+    struct ReadyBefore {
+        bool operator()(const ReadyHost& a, const ReadyHost& b) const noexcept { return ahead(a.key, b.key); }
+    };
+
+    // A failed request waiting out its backoff, under the key it was first queued with.
+    struct Retry {
+        Key key;
+        Request request;
+    };
+
+    // What is still worth knowing about a host once it has no work: a crawl delay that has not run out and,
+    // under a page cap, how many pages it has had.
+    struct HostMemo {
+        uint64_t ready_at;
+        std::size_t accepted;
+    };
+
+    // Only hosts with something queued, in flight or scheduled have a HostQueue. Retired ones are kept in
+    // `host_store` for reuse rather than freed, since stale ranked entries may still point at them.
+    std::unordered_map<std::string, HostQueue*> hosts;
+    std::deque<HostQueue> host_store;
+    std::vector<HostQueue*> spare_hosts;
+    std::unordered_map<std::string, HostMemo> memos;
+    std::size_t memo_sweep_at {min_memo_sweep};
+    static constexpr std::size_t min_memo_sweep = 1024;
+    // Hosts seen for the first time, kept only while watched (for DNS prefetch). When prefetching falls this far
+    // behind, newer hosts are skipped; curl resolves them itself. A retired queue forgets its host, so the
+    // fingerprints of hosts already listed are kept to list each once, however often it comes back.
+    std::deque<std::string> new_hosts;
+    std::unordered_set<uint64_t> listed_hosts;
+    static constexpr std::size_t max_new_hosts = 4096;
+    bool watch_hosts {false};
+    std::deque<HostQueue*> ready_hosts;
+    DaryHeap<ReadyHost, ReadyBefore> ranked_hosts;
+    // Hosts waiting out a crawl delay and requests waiting out a retry backoff, on timer wheels so that a
+    // frontier with millions of them schedules each in O(1).
+    TimerWheel<HostQueue*> delayed_hosts { now() };
+    TimerWheel<Retry> retries { now() };
+    std::unique_ptr<VisitedSet> visited_urls { std::make_unique<FingerprintSet>() };
+    URLCanonicalizer canonicalizer_;
+    FrontierOrder order {FrontierOrder::RoundRobin};
+    ScoreFunction score;
+    std::unique_ptr<SpillStore> spill;
+    // Only kept while checkpointing; `flights` maps in-flight URLs to their checkpoint tickets.
+    std::unique_ptr<CrawlJournal> journal;
+    std::unordered_multimap<std::string, uint64_t> flights;
+    std::size_t hot_limit {0};
+    std::size_t hot {0};
+    std::size_t pending {0};
+    std::size_t in_flight {0};
+    std::size_t ready_count {0};
+    uint64_t sequence {0};
+    uint64_t crawl_delay_ms {0};
+    std::size_t max_host_in_flight {0};
+    std::size_t max_depth {std::numeric_limits<std::size_t>::max()};
+    std::size_t max_host_pages {0};
+    std::mutex mtx;
+
+    static uint64_t now() noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline const bool ranked() const noexcept { return order != FrontierOrder::RoundRobin; }
+
+    Key keyFor(const Request& request, const std::string_view host, const std::string_view anchor) {
+        const uint64_t seq = sequence++;
+        Key key {request.priority, 0.0, std::numeric_limits<uint64_t>::max() - seq};
+        switch (order) {
+            case FrontierOrder::RoundRobin: break;
+            case FrontierOrder::BreadthFirst: key.rank = -static_cast<double>(request.depth); break;
+            case FrontierOrder::DepthFirst: key.rank = static_cast<double>(request.depth); key.tie = seq; break;
+            case FrontierOrder::BestFirst:
+                if (score) key.rank = score(ScoreContext{request.url, host, anchor, request.depth, request.priority});
+                break;
+        }
+        return key;
+    }
+
+    HostQueue& hostFor(const std::string& name) {
+        auto [it, inserted] = hosts.try_emplace(name, nullptr);
+        if (!inserted) return *it->second;
+        HostQueue* host;
+        if (!spare_hosts.empty()) {
+            host = spare_hosts.back();
+            spare_hosts.pop_back();
+        } else {
+            host = &host_store.emplace_back();
+        }
+        host->name = name;
+        if (auto m = memos.find(name); m != memos.end()) {
+            host->ready_at = m->second.ready_at;
+            host->accepted = m->second.accepted;
+            memos.erase(m);
+        } else if (watch_hosts && new_hosts.size() < max_new_hosts && listed_hosts.insert(fingerprint64(name)).second) {
+            new_hosts.emplace_back(name);
+        }
+        it->second = host;
+        return *host;
+    }
+
+    // Frees the queue of a host that has nothing queued, in flight or scheduled, so the frontier's memory follows
+    // the hosts with work rather than every host ever seen. The host's version survives reuse, which keeps any
+    // ranked entry still pointing at it stale.
+    void retire(HostQueue& host) {
+        if (!host.empty() || host.in_flight || host.scheduled || host.ready) return;
+        const uint64_t t = now();
+        if (host.ready_at > t || (max_host_pages && host.accepted)) memos[host.name] = HostMemo{host.ready_at, host.accepted};
+        hosts.erase(host.name);
+        host.name = std::string();
+        host.heap = DaryHeap<Entry, EntryBefore>();
+        host.slots = std::vector<Request>();
+        host.free_slots = std::vector<uint32_t>();
+        host.ready_at = 0;
+        host.limit = 0;
+        host.accepted = 0;
+        spare_hosts.emplace_back(&host);
+        if (memos.size() >= memo_sweep_at) sweepMemos(t);
+    }
+
+    // Drops memos whose delay has run out and that no page cap needs.
+    void sweepMemos(const uint64_t t) {
+        for (auto it = memos.begin(); it != memos.end();) {
+            if (it->second.ready_at <= t && !(max_host_pages && it->second.accepted)) it = memos.erase(it);
+            else ++it;
+        }
+        memo_sweep_at = std::max(min_memo_sweep, memos.size() * 2);
+    }
+
+    void markReady(HostQueue& host) {
+        host.ready = true;
+        ++ready_count;
+        if (ranked()) ranked_hosts.push(ReadyHost{host.heap.top().key, &host, host.version});
+        else ready_hosts.emplace_back(&host);
+    }
+
+    void schedule(HostQueue& host, const uint64_t t) {
+        if (host.scheduled || host.empty()) return;
+        const std::size_t cap = host.limit ? host.limit : max_host_in_flight;
+        if (cap && host.in_flight >= cap) return;
+        host.scheduled = true;
+        if (host.ready_at <= t) markReady(host);
+        else delayed_hosts.insert(host.ready_at, &host);
+    }
+
+    void promote(const uint64_t t) {
+        retries.advance(t, [this](Retry&& retry){
+            enqueue(hostFor(hostOf(retry.request.url)), std::move(retry.request), retry.key);
+        });
+        delayed_hosts.advance(t, [this, t](HostQueue*&& host){
+            // Deferred again since it was queued.
+            if (host->ready_at > t) delayed_hosts.insert(host->ready_at, host);
+            else markReady(*host);
+        });
+    }
+
+    // A host deferred while already queued as ready goes back to waiting once it reaches the front.
+    void holdDeferred(const uint64_t t) {
+        for (;;) {
+            if (ranked()) skipStale();
+            if (ranked() ? ranked_hosts.empty() : ready_hosts.empty()) return;
+            HostQueue* host = ranked() ? ranked_hosts.top().host : ready_hosts.front();
+            if (host->ready_at <= t) return;
+            if (ranked()) ranked_hosts.pop();
+            else ready_hosts.pop_front();
+            host->ready = false;
+            ++host->version;
+            --ready_count;
+            delayed_hosts.insert(host->ready_at, host);
+        }
+    }
+
+    // Drops ranked entries whose host has since been popped or has a better head than the entry recorded.
+    void skipStale() {
+        while (!ranked_hosts.empty()) {
+            const ReadyHost& top = ranked_hosts.top();
+            if (top.host->ready && top.version == top.host->version) return;
+            ranked_hosts.pop();
+        }
+    }
+
+    void enqueue(HostQueue& host, Request&& request, const Key key) {
+        uint32_t slot;
+        if (!host.free_slots.empty()) {
+            slot = host.free_slots.back();
+            host.free_slots.pop_back();
+            host.slots[slot] = std::move(request);
+        } else {
+            slot = static_cast<uint32_t>(host.slots.size());
+            host.slots.emplace_back(std::move(request));
+        }
+
+        const bool new_head = host.empty() || ahead(key, host.heap.top().key);
+        host.heap.push(Entry{key, slot});
+        ++hot;
+
+        // A better head changes the host's place among the ranked ready hosts; re-queue it, the old entry goes stale.
+        if (new_head && host.ready && ranked()) {
+            ++host.version;
+            ranked_hosts.push(ReadyHost{key, &host, host.version});
+        }
+        schedule(host, now());
+    }
+
+    template<typename Fresh>
+    const bool admit(Request&& request, const std::string_view anchor, Fresh&& fresh) {
+        const std::string_view canonical = canonicalizer_.canonicalize(request.url);
+        if (request.depth > max_depth) return false;
+        // Refused before it is marked visited while the disk tier is behind, so a later link can still get in.
+        const bool spills = spill && (hot >= hot_limit || !spill->empty());
+        if (spills && spill->backlogged()) return false;
+        std::string host_name = hostOf(canonical);
+        auto& host = hostFor(host_name);
+        if ((max_host_pages && host.accepted >= max_host_pages) || !fresh(canonical, request)) {
+            retire(host);
+            return false;
+        }
+        request.url.assign(canonical.data(), canonical.size());
+        const Key key = keyFor(request, host_name, anchor);
+        ++host.accepted;
+        ++pending;
+        if (journal) journal->addQueued(SpilledRequest{request, key.rank, key.tie});
+        // Once anything has spilled, newer URLs queue behind it so the disk tier stays in arrival order.
+        if (spills) {
+            spill->push(SpilledRequest{std::move(request), key.rank, key.tie});
+            retire(host);
+        } else {
+            enqueue(host, std::move(request), key);
+        }
+        return true;
+    }
+
+    // Marks a dedup key visited, journaling it for the next checkpoint.
+    const bool visit(const std::string_view key) {
+        const uint64_t fp = fingerprint64(key);
+        if (!visited_urls->insertFingerprint(fp)) return false;
+        if (journal) journal->addVisited(fp);
+        return true;
+    }
+
+    // Queues a request that was admitted before (by a previous run) under its original key.
+    void readmit(Request&& request, const Key key) {
+        auto& host = hostFor(hostOf(request.url));
+        ++host.accepted;
+        ++pending;
+        if (spill && (hot >= hot_limit || !spill->empty())) {
+            spill->push(SpilledRequest{std::move(request), key.rank, key.tie});
+            retire(host);
+        } else {
+            enqueue(host, std::move(request), key);
+        }
+    }
+
+    // Tops the hot tier back up to `hot_limit` from disk once it is half empty. Never waits: a batch still being
+    // read simply isn't there yet, and the store's ready callback says when to look again.
+    void refill() {
+        while (spill && !spill->empty() && hot <= hot_limit / 2) {
+            auto batch = spill->take(hot_limit - hot);
+            if (batch.empty()) return;
+            for (auto& item : batch) {
+                const Key key {item.request.priority, item.rank, item.tie};
+                enqueue(hostFor(hostOf(item.request.url)), std::move(item.request), key);
+            }
+        }
+    }
 
 public:
     explicit URLRequestManager() = default;
     URLRequestManager(const URLRequestManager&) = delete;
     URLRequestManager& operator=(const URLRequestManager&) = delete;
 
-    const bool addURL(const std::string& url, const size_t depth = 0) {
-        if (visited_urls.find(url) == visited_urls.end()) {
-            visited_urls.insert(url); 
-            url_queue.emplace_front(url, depth);
-            return true; 
+    std::unique_lock<std::mutex> lock() {
+        return std::unique_lock<std::mutex>(mtx);
+    }
+
+    // Lower-cased authority without userinfo, e.g. "example.com:8080".
+    static std::string hostOf(const std::string_view url) {
+        std::size_t begin = url.find("://");
+        begin = begin == std::string_view::npos ? 0 : begin + 3;
+        std::size_t end = url.find_first_of("/?#", begin);
+        if (end == std::string_view::npos) end = url.size();
+        const std::size_t at = url.rfind('@', end);
+        if (at != std::string_view::npos && at >= begin) begin = at + 1;
+
+        std::string host(url.substr(begin, end - begin));
+        for (auto& c : host) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
         }
-        return false; 
+        return host;
     }
 
-    inline const std::unordered_set<std::string>& getVisited() const noexcept{
-        return visited_urls;
+    void setCrawlDelayMs(const uint64_t ms) noexcept{
+        crawl_delay_ms = ms;
     }
 
-    const std::pair<std::string, size_t> popURL() noexcept{ 
-        const auto url = std::move(url_queue.back()); 
-        url_queue.pop_back(); 
+    // 0 lifts the cap.
+    void setMaxInFlightPerHost(const std::size_t n) {
+        max_host_in_flight = n;
+        const uint64_t t = now();
+        for (auto& [name, host] : hosts) schedule(*host, t);
+    }
+
+    // Overrides the per-host cap for one host (as hostOf spells it) while it has work; 0 goes back to the common one.
+    void setHostLimit(const std::string& name, const std::size_t n) {
+        auto it = hosts.find(name);
+        if (it == hosts.end()) return;
+        it->second->limit = n;
+        schedule(*it->second, now());
+    }
+
+    // URLs deeper than this are dropped on arrival (and not marked visited, so a shallower link still gets in).
+    void setMaxDepth(const std::size_t depth) noexcept{
+        max_depth = depth;
+    }
+
+    // Most URLs ever queued for one host; 0 lifts the cap.
+    void setMaxPagesPerHost(const std::size_t n) noexcept{
+        max_host_pages = n;
+    }
+
+    // Ranks are fixed when a URL is queued, so the order can only change while the frontier is empty.
+    // BestFirst ranks by `fn` (higher first); without one it behaves like FIFO.
+    void setOrder(const FrontierOrder o, ScoreFunction fn = nullptr) {
+        if (pending) throw std::logic_error("Frontier order can only change while the frontier is empty");
+        order = o;
+        score = std::move(fn);
+        ready_hosts.clear();
+        ranked_hosts.clear();
+    }
+
+    inline const FrontierOrder getOrder() const noexcept{
+        return order;
+    }
+
+    // Keeps at most `hot` requests in memory and spills the rest to segment files of about `segment_bytes`
+    // under `dir`, removed again when the frontier goes away. While the writer thread is behind, URLs that
+    // would spill are refused (addURL returns false) rather than waiting for the disk. `notify` is called from the spill thread
+    // whenever requests are back from disk. An empty `dir` turns spilling off, which needs an empty disk tier.
+    void setSpill(const std::string& dir, const std::size_t hot, const std::size_t segment_bytes = 64u << 20,
+                  std::function<void()> notify = nullptr) {
+        if (spill && !spill->empty()) throw std::logic_error("Cannot move the frontier's spill while it holds requests");
+        spill.reset();
+        hot_limit = hot;
+        if (dir.empty()) return;
+        if (!hot) throw std::invalid_argument("Hot frontier size must be positive");
+        spill = std::make_unique<SpillStore>(dir, segment_bytes);
+        spill->onReady(std::move(notify));
+    }
+
+    // Records every host seen from now on, for takeNewHosts.
+    void watchHosts(const bool val) {
+        watch_hosts = val;
+        if (val) return;
+        new_hosts.clear();
+        listed_hosts.clear();
+    }
+
+    // Moves up to `max` newly seen hosts (as hostOf spells them) into `out`, oldest first.
+    void takeNewHosts(std::vector<std::string>& out, std::size_t max) {
+        while (max-- && !new_hosts.empty()) {
+            out.emplace_back(std::move(new_hosts.front()));
+            new_hosts.pop_front();
+        }
+    }
+
+    // Starts recording changes for checkpoints. Like the order, only while the frontier is empty.
+    void startJournal() {
+        if (pending || in_flight) throw std::logic_error("Checkpointing must start before the frontier is seeded");
+        journal = std::make_unique<CrawlJournal>();
+        flights.clear();
+    }
+
+    // Changes since the previous call, for CheckpointStore::write.
+    CrawlJournal takeJournal() {
+        CrawlJournal out;
+        if (!journal) return out;
+        std::swap(out, *journal);
+        out.sequence = sequence;
+        return out;
+    }
+
+    // Loads a checkpoint opened with CheckpointStore::open into this (empty) frontier: the visited set is
+    // replayed, and requests that were pending or in flight are queued again with their original rank.
+    // Journaling, if started, continues from it. Returns the number of requests re-queued.
+    std::size_t restore(const CheckpointStore& store) {
+        if (pending || in_flight) throw std::logic_error("Can only restore a checkpoint into an empty frontier");
+        const std::size_t n = store.load(
+            [this](const uint64_t fp) { visited_urls->insertFingerprint(fp); },
+            [this](SpilledRequest&& item) {
+                const Key key {item.request.priority, item.rank, item.tie};
+                readmit(std::move(item.request), key);
+            });
+        sequence = std::max(sequence, store.sequence());
+        return n;
+    }
+
+    // Swaps the dedup backend; URLs recorded by the previous one are forgotten.
+    void setVisitedSet(std::unique_ptr<VisitedSet> set) {
+        if (!set) throw std::invalid_argument("Visited set must not be null");
+        visited_urls = std::move(set);
+    }
+
+    inline URLCanonicalizer& canonicalizer() noexcept{
+        return canonicalizer_;
+    }
+
+    // Dedups and queues the canonical form, so spelling variants of one URL are fetched once.
+    // `profile` is the option snapshot the request will be sent with; null leaves it to the loop that fetches it.
+    // `anchor` is the link text, seen only by a best-first score function.
+    const bool addURL(const std::string& url, const size_t depth = 0, std::shared_ptr<const OptionProfile> profile = nullptr,
+                      const std::string_view anchor = {}) {
+        return admit(Request(url, depth, std::move(profile)), anchor, [this](const std::string_view canonical, const Request&){
+            return visit(canonical);
+        });
+    }
+
+    // As addURL, keeping the request's overrides and priority. Requests with a payload (POST, PUT, ...)
+    // are deduplicated on verb, URL and body together.
+    const bool addRequest(Request request, const std::string_view anchor = {}) {
+        return admit(std::move(request), anchor, [this](const std::string_view canonical, const Request& r){
+            if (!r.dedup) return true;
+            if (!r.hasPayloadIdentity()) return visit(canonical);
+            std::string key(canonical);
+            key.append(1, '\n').append(r.method()).append(1, '\n').append(r.body());
+            return visit(key);
+        });
+    }
+
+    inline const VisitedSet& getVisited() const noexcept{
+        return *visited_urls;
+    }
+
+    const bool isVisited(const std::string& url) {
+        return visited_urls->contains(canonicalizer_.canonicalize(url));
+    }
+
+    // Only valid after hasReadyURLs() returned true. `key`, if given, receives the request's place in the order,
+    // for retry().
+    Request popURL(Key* key = nullptr) noexcept{ 
+        HostQueue* host;
+        if (ranked()) {
+            host = ranked_hosts.top().host;
+            ranked_hosts.pop();
+        } else {
+            host = ready_hosts.front();
+            ready_hosts.pop_front();
+        }
+        host->scheduled = false;
+        host->ready = false;
+        ++host->version;
+        --ready_count;
+
+        const Entry entry = host->heap.pop();
+        const uint32_t slot = entry.slot;
+        Request url = std::move(host->slots[slot]);
+        if (journal) flights.emplace(url.url, entry.key.tie);
+        if (key) *key = entry.key;
+        host->free_slots.emplace_back(slot);
+        --pending;
+        --hot;
+        ++host->in_flight;
+        ++in_flight;
+
+        const uint64_t t = now();
+        host->ready_at = std::max(host->ready_at, t + crawl_delay_ms);
+        schedule(*host, t);
         return url; 
     }
+
+    // The transfer for `url` is over; its host may take another request. `completed` is false for transfers
+    // that were abandoned, which a checkpoint then still counts as pending.
+    void releaseHost(const std::string& url, const bool completed = true) {
+        if (journal) {
+            if (auto f = flights.find(url); f != flights.end()) {
+                if (completed) journal->addDone(f->second);
+                flights.erase(f);
+            }
+        }
+        auto it = hosts.find(hostOf(url));
+        if (it == hosts.end()) return;
+        auto& host = *it->second;
+        if (host.in_flight) --host.in_flight;
+        schedule(host, now());
+        retire(host);
+    }
+
+    // Queues `request` again after `delay_ms`, in place of releasing its host. `key` is the one popURL gave out,
+    // so the request keeps its place in the order (and, in a checkpoint, stays pending under its ticket); it goes
+    // through the host's politeness like any other.
+    void retry(Request&& request, const Key& key, const uint64_t delay_ms) {
+        if (journal) {
+            if (auto f = flights.find(request.url); f != flights.end()) flights.erase(f);
+        }
+        auto it = hosts.find(hostOf(request.url));
+        if (it != hosts.end()) {
+            auto& host = *it->second;
+            if (host.in_flight) --host.in_flight;
+            schedule(host, now());
+            retire(host);
+        }
+        ++pending;
+        retries.insert(now() + delay_ms, Retry{key, std::move(request)});
+    }
+
+    // Sends nothing more to `name` (as hostOf spells it) for `delay_ms`, e.g. after a 429 with Retry-After.
+    // At most one request already picked for it may still go out.
+    void deferHost(const std::string& name, const uint64_t delay_ms) {
+        auto it = hosts.find(name);
+        if (it == hosts.end()) return;
+        auto& host = *it->second;
+        host.ready_at = std::max(host.ready_at, now() + delay_ms);
+    }
+
+    // Requests waiting out a retry backoff, already counted in getPendingUrlQueueSize().
+    const std::size_t getRetrySize() const noexcept{
+        return retries.size();
+    }
+
+    // The URL has been fully handled (callbacks included); only then can the crawl be considered drained.
+    void markDone(const std::size_t n = 1) noexcept{
+        in_flight = n < in_flight ? in_flight - n : 0;
+    }
+
     void clear() noexcept{
-        url_queue.clear();
+        hosts.clear();
+        host_store.clear();
+        spare_hosts.clear();
+        memos.clear();
+        memo_sweep_at = min_memo_sweep;
+        new_hosts.clear();
+        listed_hosts.clear();
+        ready_hosts.clear();
+        ranked_hosts.clear();
+        delayed_hosts.clear();
+        retries.clear();
+        if (spill) spill->clear();
+        if (journal) {
+            journal->clear();
+            journal->reset = true;
+        }
+        hot = 0;
+        pending = 0;
+        ready_count = 0;
     }
 
     const std::size_t getPendingUrlQueueSize() const noexcept{
-        return url_queue.size();
+        return pending;
+    }
+
+    // Requests waiting in the disk tier, already counted in getPendingUrlQueueSize().
+    const std::size_t getSpilledSize() const noexcept{
+        return spill ? spill->size() : 0;
     }
 
     const std::size_t getVisitedUrlSize() const noexcept{
-        return visited_urls.size();
+        return visited_urls->size();
+    }
+
+    const std::size_t getInFlight() const noexcept{
+        return in_flight;
+    }
+
+    // Hosts with something queued, in flight or waiting to be scheduled.
+    const std::size_t getHostCount() const noexcept{
+        return hosts.size();
+    }
+
+    const bool hasURLs() const noexcept { return pending != 0; }
+
+    const bool hasReadyURLs() {
+        refill();
+        const uint64_t t = now();
+        promote(t);
+        holdDeferred(t);
+        return ready_count != 0;
+    }
+
+    // Milliseconds until a delayed host becomes ready or a retry is due, or -1 when nothing is waiting.
+    // Deadlines more than 256 ms out may be reported early; asking again then gives the rest of the wait.
+    const long msUntilReady() const noexcept {
+        const uint64_t t = now();
+        const int64_t hosts_wait = delayed_hosts.msUntilNext(t), retries_wait = retries.msUntilNext(t);
+        if (hosts_wait < 0) return static_cast<long>(retries_wait);
+        if (retries_wait < 0) return static_cast<long>(hosts_wait);
+        return static_cast<long>(std::min(hosts_wait, retries_wait));
     }
 
-    const bool hasURLs() const noexcept { return !url_queue.empty(); }
+    const bool isDrained() const noexcept { return pending == 0 && in_flight == 0; }
 
 };
 
@@ -0,0 +1,195 @@
+#ifndef VISITEDS
+#define VISITEDS
+
+#include <vector>
+#include <algorithm>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+
+// 64-bit fingerprint of a URL: 8 bytes per round, murmur3 finaliser for avalanche.
+inline uint64_t fingerprint64(const std::string_view s) noexcept {
+    constexpr uint64_t mul = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = 0xCBF29CE484222325ULL ^ (s.size() * mul);
+    std::size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, s.data() + i, 8);
+        h = (h ^ w) * mul;
+        h ^= h >> 29;
+    }
+    uint64_t tail = 0;
+    if (i < s.size()) std::memcpy(&tail, s.data() + i, s.size() - i);
+    h = (h ^ tail) * mul;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Dedup backend for the frontier. Only answers "seen before?", so it never has to keep the URL strings.
+class VisitedSet {
+public:
+    virtual ~VisitedSet() noexcept = default;
+
+    // Records the URL; false if it was (or, for approximate sets, may have been) seen already.
+    virtual const bool insert(const std::string_view url) = 0;
+    // Same, given fingerprint64() of the URL; lets a checkpoint replay the set without the strings.
+    virtual const bool insertFingerprint(const uint64_t fp) = 0;
+    virtual const bool contains(const std::string_view url) const = 0;
+    virtual const std::size_t size() const noexcept = 0;
+    virtual const std::size_t memoryUsage() const noexcept = 0;
+    virtual void clear() noexcept = 0;
+};
+
+// Exact up to 64-bit fingerprint collisions (~1e-4 odds at 1e8 URLs): a flat, linearly probed table of fingerprints.
+class FingerprintSet final : public VisitedSet {
+    std::vector<uint64_t> slots;
+    std::size_t count {0};
+    std::size_t mask;
+
+    static std::size_t roundUp(std::size_t n) noexcept {
+        std::size_t p = 16;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    const bool place(std::vector<uint64_t>& table, const std::size_t m, const uint64_t fp) noexcept {
+        for (std::size_t i = fp & m;; i = (i + 1) & m) {
+            if (table[i] == fp) return false;
+            if (table[i] == 0) {
+                table[i] = fp;
+                return true;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<uint64_t> bigger(slots.size() * 2, 0);
+        const std::size_t m = bigger.size() - 1;
+        for (const uint64_t fp : slots) {
+            if (fp) place(bigger, m, fp);
+        }
+        slots.swap(bigger);
+        mask = m;
+    }
+
+    // 0 marks an empty slot.
+    static uint64_t key(const uint64_t fp) noexcept {
+        return fp ? fp : 1;
+    }
+
+public:
+    explicit FingerprintSet(const std::size_t expected = 1024) : slots(roundUp(expected + expected / 3 + 1), 0), mask(slots.size() - 1) {}
+
+    const bool insert(const std::string_view url) override {
+        return insertFingerprint(fingerprint64(url));
+    }
+
+    const bool insertFingerprint(const uint64_t fp) override {
+        if ((count + 1) * 4 > slots.size() * 3) grow();
+        if (!place(slots, mask, key(fp))) return false;
+        ++count;
+        return true;
+    }
+
+    const bool contains(const std::string_view url) const override {
+        const uint64_t fp = key(fingerprint64(url));
+        for (std::size_t i = fp & mask;; i = (i + 1) & mask) {
+            if (slots[i] == fp) return true;
+            if (slots[i] == 0) return false;
+        }
+    }
+
+    const std::size_t size() const noexcept override { return count; }
+    const std::size_t memoryUsage() const noexcept override { return slots.capacity() * sizeof(uint64_t); }
+
+    void clear() noexcept override {
+        std::fill(slots.begin(), slots.end(), 0);
+        count = 0;
+    }
+};
+
+// Approximate, fixed-size: sized for `expected` URLs at `fp_rate`, shrunk to `max_bytes` when given.
+// A false positive means a new URL is treated as visited and skipped; it never causes a refetch.
+class BloomFilter final : public VisitedSet {
+    std::vector<uint64_t> bits;
+    uint64_t nbits;
+    unsigned hashes;
+    std::size_t count {0};
+
+    struct Probe {
+        uint64_t h1;
+        uint64_t h2;
+    };
+
+    static Probe probeOf(const uint64_t h1) noexcept {
+        return { h1, ((h1 >> 32) | (h1 << 32)) * 0x9E3779B97F4A7C15ULL | 1 };
+    }
+
+    inline uint64_t bitAt(const Probe& p, const unsigned i) const noexcept {
+        return (p.h1 + i * p.h2) % nbits;
+    }
+
+public:
+    BloomFilter(const std::size_t expected, const double fp_rate, const std::size_t max_bytes = 0) {
+        if (expected == 0 || fp_rate <= 0.0 || fp_rate >= 1.0) {
+            throw std::invalid_argument("Bloom filter needs expected > 0 and 0 < fp_rate < 1");
+        }
+        const double ln2 = std::log(2.0);
+        double m = -static_cast<double>(expected) * std::log(fp_rate) / (ln2 * ln2);
+        if (max_bytes) m = std::min(m, static_cast<double>(max_bytes) * 8.0);
+        nbits = std::max<uint64_t>(64, static_cast<uint64_t>(m));
+        hashes = static_cast<unsigned>(std::lround(static_cast<double>(nbits) / expected * ln2));
+        hashes = std::min(16u, std::max(1u, hashes));
+        bits.assign((nbits + 63) / 64, 0);
+    }
+
+    const bool insert(const std::string_view url) override {
+        return insertFingerprint(fingerprint64(url));
+    }
+
+    const bool insertFingerprint(const uint64_t fp) override {
+        const Probe p = probeOf(fp);
+        bool fresh = false;
+        for (unsigned i = 0; i < hashes; ++i) {
+            const uint64_t bit = bitAt(p, i);
+            uint64_t& word = bits[bit >> 6];
+            const uint64_t flag = 1ULL << (bit & 63);
+            if (!(word & flag)) fresh = true;
+            word |= flag;
+        }
+        if (fresh) ++count;
+        return fresh;
+    }
+
+    const bool contains(const std::string_view url) const override {
+        const Probe p = probeOf(fingerprint64(url));
+        for (unsigned i = 0; i < hashes; ++i) {
+            const uint64_t bit = bitAt(p, i);
+            if (!(bits[bit >> 6] & (1ULL << (bit & 63)))) return false;
+        }
+        return true;
+    }
+
+    // URLs accepted as new; hidden false positives are not counted.
+    const std::size_t size() const noexcept override { return count; }
+    const std::size_t memoryUsage() const noexcept override { return bits.capacity() * sizeof(uint64_t); }
+
+    void clear() noexcept override {
+        std::fill(bits.begin(), bits.end(), 0);
+        count = 0;
+    }
+
+    // Expected false-positive rate at the current fill.
+    const double falsePositiveRate() const noexcept {
+        return std::pow(1.0 - std::exp(-static_cast<double>(hashes) * count / nbits), hashes);
+    }
+};
+
+#endif
\ No newline at end of file
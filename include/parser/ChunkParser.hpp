@@ -0,0 +1,63 @@
+#ifndef CHUNKPARSER
+#define CHUNKPARSER
+
+#include "Document.hpp"
+
+// Builds one document incrementally: feed() bytes as they arrive, finish() once the body is complete.
+// Holds its own lexbor parser, so one instance serves one transfer at a time.
+class ChunkParser {
+    std::unique_ptr<lxb_html_parser_t, decltype(&lxb_html_parser_destroy)>
+        parser {lxb_html_parser_create(), &lxb_html_parser_destroy};
+    std::unique_ptr<lxb_html_document_t, decltype(&lxb_html_document_destroy)>
+        document {nullptr, &lxb_html_document_destroy};
+
+    static void check(const lxb_status_t status, const char* errMsg) {
+        if (status != LXB_STATUS_OK) {
+            throw std::runtime_error(errMsg);
+        }
+    }
+
+    void begin() {
+        document.reset(lxb_html_parse_chunk_begin(parser.get()));
+        if (!document) {
+            throw std::runtime_error("Failed to begin chunked HTML parse");
+        }
+    }
+
+public:
+    ChunkParser() {
+        check(lxb_html_parser_init(parser.get()), "Failed to initialize HTML parser");
+    }
+
+    ChunkParser(const ChunkParser&) = delete;
+    ChunkParser& operator=(const ChunkParser&) = delete;
+
+    ~ChunkParser() {
+        abort();
+    }
+
+    inline const bool active() const noexcept { return document != nullptr; }
+
+    void feed(const char* ptr, const std::size_t len) {
+        if (!document) begin();
+        check(lxb_html_parse_chunk_process(parser.get(), reinterpret_cast<const lxb_char_t *>(ptr), len),
+              "Failed to parse HTML chunk");
+    }
+
+    Document finish() {
+        if (!document) begin();
+        const lxb_status_t status = lxb_html_parse_chunk_end(parser.get());
+        auto doc = std::move(document);
+        check(status, "Failed to parse HTML");
+        return Document(std::move(doc));
+    }
+
+    // Throws away a half-built document, e.g. after a failed transfer.
+    void abort() noexcept {
+        if (!document) return;
+        lxb_html_parse_chunk_end(parser.get());
+        document.reset();
+    }
+};
+
+#endif
\ No newline at end of file
@@ -1,20 +1,33 @@
 #ifndef DOC
 #define DOC
 
-#include "Node.hpp"
+#include "NodeList.hpp"
 
 class Document {
 public:
 
+    // The arena sits behind a pointer so that it keeps its address when the Document moves: nodes find it
+    // through the lexbor document's user slot. NodeLists only hold it weakly.
     Document(std::unique_ptr<lxb_html_document_t, decltype(&lxb_html_document_destroy)>&& doc)
-        : doc_(std::move(doc)), collection_(doc_.get()) {}
+        : doc_(std::move(doc)), arena_(std::make_shared<NodeArena>(doc_.get())) {
+        lxb_dom_interface_node(doc_.get())->user = arena_.get();
+    }
 
-    std::unique_ptr<Node> rootElement() {
+    Node rootElement() {
         lxb_html_body_element_t* bodyElement = lxb_html_document_body_element(doc_.get());
         if (!bodyElement) {
             throw std::runtime_error("Failed to obtain body element");
         }
-        return std::make_unique<Node>(lxb_dom_interface_node(bodyElement), doc_.get(), collection_);
+        return Node(lxb_dom_interface_node(bodyElement));
+    }
+
+    // Selector queries over the whole document, head included, so "title" or "meta[name=description]" match.
+    Node querySelector(const std::string& selectors) const {
+        return Node(lxb_dom_interface_node(doc_.get())).querySelector(selectors);
+    }
+
+    std::unique_ptr<NodeList> querySelectorAll(const std::string& selectors) const {
+        return Node(lxb_dom_interface_node(doc_.get())).querySelectorAll(selectors);
     }
 
 private:
@@ -22,7 +35,7 @@ private:
         lxb_dom_collection_destroy(collection,true);
     }
     std::unique_ptr<lxb_html_document_t, decltype(&lxb_html_document_destroy)> doc_;
-    DomCollection collection_;
+    std::shared_ptr<NodeArena> arena_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,227 @@
+#ifndef EXTRACTOR
+#define EXTRACTOR
+
+#include <memory>
+#include "TagScanner.hpp"
+
+// Pulls one kind of value out of a page as it streams past a TagScanner. Once every extractor
+// registered for a crawl is done(), the rest of the body is not needed and the transfer is cut short.
+class Extractor {
+protected:
+    std::string key;
+    std::vector<std::string> found;
+    bool satisfied {false};
+
+    // <body> or </head>: anything that only lives in the head can stop waiting.
+    static bool endsHead(const std::string_view name, const bool closing) noexcept {
+        return closing ? name == "head" : name == "body";
+    }
+
+public:
+    explicit Extractor(std::string k) : key(std::move(k)) {}
+    virtual ~Extractor() = default;
+
+    // A fresh copy for another transfer; registered extractors act as prototypes.
+    virtual std::unique_ptr<Extractor> clone() const = 0;
+
+    // Return true to receive the text of this element through onText (raw-text elements only).
+    virtual bool onStartTag(const HtmlTag& tag) = 0;
+    virtual void onText(std::string_view, std::string_view) {}
+    virtual void onEndTag(std::string_view name) {
+        if (endsHead(name, true)) satisfied = true;
+    }
+
+    const std::string& name() const noexcept { return key; }
+    const bool done() const noexcept { return satisfied; }
+    const std::vector<std::string>& values() const noexcept { return found; }
+
+    void reset() noexcept {
+        found.clear();
+        satisfied = false;
+    }
+};
+
+// Text of <title>.
+class TitleExtractor final : public Extractor {
+public:
+    explicit TitleExtractor(std::string k = "title") : Extractor(std::move(k)) {}
+
+    std::unique_ptr<Extractor> clone() const override { return std::make_unique<TitleExtractor>(key); }
+
+    bool onStartTag(const HtmlTag& tag) override {
+        if (endsHead(tag.name, false)) satisfied = true;
+        return !satisfied && tag.name == "title";
+    }
+
+    void onText(std::string_view, const std::string_view text) override {
+        const std::size_t first = text.find_first_not_of(" \t\r\n\f");
+        const std::size_t last = text.find_last_not_of(" \t\r\n\f");
+        std::string title = first == std::string_view::npos ? std::string() : std::string(text.substr(first, last - first + 1));
+        decodeEntities(title);
+        found.emplace_back(std::move(title));
+        satisfied = true;
+    }
+};
+
+// href of <link rel="..."> in the head, e.g. "canonical", "alternate", "amphtml".
+class LinkRelExtractor final : public Extractor {
+    std::string rel;
+
+    static bool hasToken(const std::string_view list, const std::string_view token) noexcept {
+        std::size_t i = 0;
+        while (i < list.size()) {
+            while (i < list.size() && list[i] == ' ') ++i;
+            std::size_t j = i;
+            while (j < list.size() && list[j] != ' ') ++j;
+            if (j > i && iequals(list.substr(i, j - i), token)) return true;
+            i = j;
+        }
+        return false;
+    }
+
+public:
+    explicit LinkRelExtractor(std::string r = "canonical") : Extractor(r), rel(std::move(r)) {}
+    LinkRelExtractor(std::string r, std::string k) : Extractor(std::move(k)), rel(std::move(r)) {}
+
+    std::unique_ptr<Extractor> clone() const override { return std::make_unique<LinkRelExtractor>(rel, key); }
+
+    bool onStartTag(const HtmlTag& tag) override {
+        if (endsHead(tag.name, false)) satisfied = true;
+        if (satisfied || tag.name != "link") return false;
+        const std::string* r = tag.attribute("rel");
+        const std::string* href = tag.attribute("href");
+        if (r && href && hasToken(*r, rel)) {
+            found.emplace_back(*href);
+            satisfied = true;
+        }
+        return false;
+    }
+};
+
+// content of <meta name="..."> or <meta property="...">, e.g. "description", "og:image".
+class MetaExtractor final : public Extractor {
+public:
+    explicit MetaExtractor(std::string k) : Extractor(std::move(k)) {}
+
+    std::unique_ptr<Extractor> clone() const override { return std::make_unique<MetaExtractor>(key); }
+
+    bool onStartTag(const HtmlTag& tag) override {
+        if (endsHead(tag.name, false)) satisfied = true;
+        if (satisfied || tag.name != "meta") return false;
+        const std::string* n = tag.attribute("name");
+        if (!n) n = tag.attribute("property");
+        const std::string* content = tag.attribute("content");
+        if (n && content && iequals(*n, key)) {
+            found.emplace_back(*content);
+            satisfied = true;
+        }
+        return false;
+    }
+};
+
+// Bodies of <script type="application/ld+json">. Stops after `limit` blocks, or at the end of the head
+// when `head_only` is set; otherwise JSON-LD in the body is collected too.
+class JsonLdExtractor final : public Extractor {
+    std::size_t limit;
+    bool head_only;
+
+public:
+    explicit JsonLdExtractor(const std::size_t max_blocks = 1, const bool only_head = false, std::string k = "json-ld") :
+        Extractor(std::move(k)), limit(max_blocks ? max_blocks : 1), head_only(only_head) {}
+
+    std::unique_ptr<Extractor> clone() const override { return std::make_unique<JsonLdExtractor>(limit, head_only, key); }
+
+    bool onStartTag(const HtmlTag& tag) override {
+        if (head_only && endsHead(tag.name, false)) satisfied = true;
+        if (satisfied || tag.name != "script") return false;
+        const std::string* type = tag.attribute("type");
+        return type && iequals(*type, "application/ld+json");
+    }
+
+    void onText(std::string_view, const std::string_view text) override {
+        found.emplace_back(text);
+        if (found.size() >= limit) satisfied = true;
+    }
+
+    void onEndTag(const std::string_view name) override {
+        if (head_only) Extractor::onEndTag(name);
+    }
+};
+
+// Runs a set of extractors over one body; done() once all of them are.
+class ExtractorSet {
+    std::vector<std::unique_ptr<Extractor>> extractors;
+    std::vector<Extractor*> text_for;
+    TagScanner scanner;
+    std::size_t remaining {0};
+
+    void settle() noexcept {
+        remaining = 0;
+        for (const auto& e : extractors) remaining += !e->done();
+    }
+
+public:
+    ExtractorSet() = default;
+
+    ExtractorSet(const std::vector<std::unique_ptr<Extractor>>& prototypes) {
+        extractors.reserve(prototypes.size());
+        for (const auto& p : prototypes) extractors.emplace_back(p->clone());
+        remaining = extractors.size();
+    }
+
+    void feed(const char* ptr, const std::size_t len) {
+        if (remaining) scanner.feed(ptr, len, *this);
+    }
+
+    inline const bool done() const noexcept { return remaining == 0; }
+
+    void reset() noexcept {
+        scanner.reset();
+        text_for.clear();
+        for (auto& e : extractors) e->reset();
+        remaining = extractors.size();
+    }
+
+    // First value found for `key`, or nullptr.
+    const std::string* get(const std::string_view key) const noexcept {
+        for (const auto& e : extractors) {
+            if (e->name() == key && !e->values().empty()) return &e->values().front();
+        }
+        return nullptr;
+    }
+
+    // Every value found for `key`.
+    const std::vector<std::string>* all(const std::string_view key) const noexcept {
+        for (const auto& e : extractors) {
+            if (e->name() == key) return &e->values();
+        }
+        return nullptr;
+    }
+
+    const std::vector<std::unique_ptr<Extractor>>& items() const noexcept { return extractors; }
+
+    // TagScanner handler interface.
+    bool onStartTag(const HtmlTag& tag) {
+        text_for.clear();
+        for (auto& e : extractors) {
+            if (!e->done() && e->onStartTag(tag)) text_for.push_back(e.get());
+        }
+        settle();
+        return !text_for.empty();
+    }
+
+    void onText(const std::string_view element, const std::string_view text) {
+        for (auto* e : text_for) e->onText(element, text);
+        text_for.clear();
+        settle();
+    }
+
+    void onEndTag(const std::string_view name) {
+        for (auto& e : extractors) {
+            if (!e->done()) e->onEndTag(name);
+        }
+        settle();
+    }
+};
+
+#endif
\ No newline at end of file
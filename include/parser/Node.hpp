@@ -1,104 +1,140 @@
 #ifndef NODE
 #define NODE
 
-#include "NodeList.hpp"
+#include "NodeArena.hpp"
+#include "SelectorCache.hpp"
 #include <regex>
 #include <unordered_map>
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+
+class NodeList;
+class ChildRange;
+class DescendantRange;
 
+// A handle to an element of a parsed Document: one pointer, trivially copyable, valid as long as the Document
+// is. A default-constructed or not-found Node is null and tests false; every call on it is still safe, giving
+// empty strings, null Nodes, empty ranges and null lists. Stepping through the tree and the child and
+// descendant ranges never allocate. The `->` operator lets code written when these calls returned
+// std::unique_ptr<Node> compile unchanged.
 class Node {
 
-    bool isElementNode(lxb_dom_node_t* node) const {
-        return node->type == LXB_DOM_NODE_TYPE_ELEMENT;
+    static bool isElementNode(lxb_dom_node_t* node) {
+        return node && node->type == LXB_DOM_NODE_TYPE_ELEMENT;
     }
 
-    bool isTextNode(lxb_dom_node_t* node) const {
-        return node->type == LXB_DOM_NODE_TYPE_TEXT;
+    static bool isTextNode(lxb_dom_node_t* node) {
+        return node && node->type == LXB_DOM_NODE_TYPE_TEXT;
     }
 
-    bool hasChildElements(lxb_dom_node_t* node) const {
-        return !lxb_dom_node_is_empty(node);
+    static bool hasChildElements(lxb_dom_node_t* node) {
+        return node && !lxb_dom_node_is_empty(node);
     }
 
-    lxb_dom_node_t* getNextElementNode(lxb_dom_node_t* node) const{
-        lxb_dom_node_t* childNode = node;
-        while(childNode!=nullptr){
-            if(isElementNode(childNode)) break;
-            childNode = lxb_dom_node_next(childNode);
-        }
-        return childNode;
+    // Selectors run from the document node as well as from elements.
+    static bool isQueryRoot(lxb_dom_node_t* node) {
+        return node->type == LXB_DOM_NODE_TYPE_ELEMENT || node->type == LXB_DOM_NODE_TYPE_DOCUMENT;
     }
 
-    lxb_dom_node_t* getPrevElementNode(lxb_dom_node_t* node) const{
-        lxb_dom_node_t* childNode = node;
-        while(childNode!=nullptr){
-            if(isElementNode(childNode)) break;
-            childNode = lxb_dom_node_prev(childNode);
-        }
-        return childNode;
+    // The Document keeps its arena in the lexbor document's user slot.
+    NodeArena& arena() const {
+        lxb_dom_document_t* document = node_->type == LXB_DOM_NODE_TYPE_DOCUMENT ? lxb_dom_interface_document(node_) : node_->owner_document;
+        return *static_cast<NodeArena*>(lxb_dom_interface_node(document)->user);
     }
 
+    // Runs a lexbor query into the arena and wraps the block it gets.
+    template<typename Fill>
+    std::unique_ptr<NodeList> collect(Fill&& fill, const bool keepEmpty = false) const;
+
 public:
-    Node(lxb_dom_node_t* node, lxb_html_document_t* document , DomCollection&  col)
-        : node_(node), document_(document),collection_(col) {}
+    Node() noexcept = default;
+
+    explicit Node(lxb_dom_node_t* node) noexcept : node_(node) {}
+
+    // The first element at or after `node` among its siblings, or null.
+    static lxb_dom_node_t* nextElement(lxb_dom_node_t* node) noexcept {
+        while (node != nullptr && !isElementNode(node)) node = lxb_dom_node_next(node);
+        return node;
+    }
+
+    // The last element at or before `node` among its siblings, or null.
+    static lxb_dom_node_t* prevElement(lxb_dom_node_t* node) noexcept {
+        while (node != nullptr && !isElementNode(node)) node = lxb_dom_node_prev(node);
+        return node;
+    }
 
     lxb_dom_node_t* get() const noexcept{
         return node_;
     }
 
+    explicit operator bool() const noexcept {
+        return node_ != nullptr;
+    }
+
+    const Node* operator->() const noexcept {
+        return this;
+    }
+
+    friend bool operator==(const Node a, const Node b) noexcept { return a.node_ == b.node_; }
+    friend bool operator!=(const Node a, const Node b) noexcept { return a.node_ != b.node_; }
+
     bool hasChildElements () const{
         return hasChildElements(node_);
     }
 
-    std::unique_ptr<Node> firstChild() const {
-        if(!hasChildElements(node_)) return nullptr;
-        lxb_dom_node_t* childNode = lxb_dom_node_first_child(node_);
-        childNode = getNextElementNode(childNode);
-        if(!childNode) return nullptr;
-        return std::make_unique<Node>(childNode ,document_ ,collection_);
+    Node parent() const noexcept {
+        lxb_dom_node_t* parentNode = node_ ? lxb_dom_node_parent(node_) : nullptr;
+        return Node(isElementNode(parentNode) ? parentNode : nullptr);
     }
 
-    std::unique_ptr<Node> lastChild() const {
-        if(!hasChildElements(node_)) return nullptr;
-        lxb_dom_node_t* childNode = lxb_dom_node_last_child(node_);
-        childNode = getPrevElementNode(childNode);
-        if(!childNode) return nullptr;
-        return std::make_unique<Node>(childNode ,document_ ,collection_);
+    Node firstChild() const noexcept {
+        return node_ ? Node(nextElement(lxb_dom_node_first_child(node_))) : Node();
     }
 
-    std::unique_ptr<Node> nextSibling() const {
-        lxb_dom_node_t* siblingNode = getNextElementNode(node_);;
-        if(!siblingNode) return nullptr;
-        return std::make_unique<Node>(siblingNode,document_,collection_);
+    Node lastChild() const noexcept {
+        return node_ ? Node(prevElement(lxb_dom_node_last_child(node_))) : Node();
     }
 
-    std::unique_ptr<Node> prevSibling() const {
-        lxb_dom_node_t* siblingNode = getPrevElementNode(node_);;
-        if(!siblingNode) return nullptr;
-        return std::make_unique<Node>(siblingNode,document_,collection_);
+    Node nextSibling() const noexcept {
+        return node_ ? Node(nextElement(lxb_dom_node_next(node_))) : Node();
     }
 
-    const std::string getAttribute(const std::string& name) const {
+    Node prevSibling() const noexcept {
+        return node_ ? Node(prevElement(lxb_dom_node_prev(node_))) : Node();
+    }
+
+    // Element children, in order.
+    ChildRange children() const noexcept;
+
+    // Every element below this one, in document order.
+    DescendantRange descendants() const noexcept;
+
+    // The element's local name, lower case for HTML; a view into the document.
+    std::string_view tagName() const noexcept {
         if(!isElementNode(node_)) return {};
+        std::size_t len = 0;
+        const lxb_char_t* name = lxb_dom_element_local_name(lxb_dom_interface_element(node_), &len);
+        return name ? std::string_view(reinterpret_cast<const char*>(name), len) : std::string_view();
+    }
 
-        auto* element = lxb_dom_interface_element(node_);
-        if (!element) {
-            throw std::runtime_error("Node is not an element");
-        }
-        auto* attr = lxb_dom_element_attr_by_name(element, reinterpret_cast<const lxb_char_t*>(name.c_str()), name.length());
-        if (!attr) {
-            return ""; 
-        }
-        std::size_t len;
-        const char* str = reinterpret_cast<const char*>(lxb_dom_attr_value(attr, &len));
-        return std::string(str,len);
+    // Like getAttribute, but a view into the document instead of a copy; empty when the attribute is missing.
+    std::string_view attributeValue(const std::string_view name) const noexcept {
+        if(!isElementNode(node_)) return {};
+        auto* attr = lxb_dom_element_attr_by_name(lxb_dom_interface_element(node_), reinterpret_cast<const lxb_char_t*>(name.data()), name.length());
+        if (!attr) return {};
+        std::size_t len = 0;
+        const lxb_char_t* value = lxb_dom_attr_value(attr, &len);
+        return value ? std::string_view(reinterpret_cast<const char*>(value), len) : std::string_view();
     }
 
-    std::unique_ptr<NodeList> getChildElements() const {
-        collection_.clean();
-        if(!hasChildElements(node_)) return nullptr;
-        return getElementsByTagName("*");
+    const std::string getAttribute(const std::string& name) const {
+        return std::string(attributeValue(name));
     }
 
+    std::unique_ptr<NodeList> getChildElements() const;
+
     const bool hasAttributes() const {
         if(!isElementNode(node_)) return false;
         return lxb_dom_element_has_attributes(lxb_dom_interface_element(node_));
@@ -118,7 +154,7 @@ public:
         lxb_dom_attr_t* attr = lxb_dom_element_first_attribute(element);
         std::size_t len = 0;
         const lxb_char_t *temp = nullptr;
-        
+
         while (attr != nullptr) {
             std::string key , value;
             temp = lxb_dom_attr_qualified_name(attr, &len);
@@ -139,7 +175,7 @@ public:
         std::string str;
         lxb_char_t * s {nullptr};
         std::size_t len = 0;
-        lxb_dom_node_t* childNode = lxb_dom_node_first_child(node_);
+        lxb_dom_node_t* childNode = node_ ? lxb_dom_node_first_child(node_) : nullptr;
         while(childNode!=nullptr){
             if(isTextNode(childNode)){
                 s = lxb_dom_node_text_content(childNode,&len);
@@ -151,66 +187,219 @@ public:
         return str;
     }
 
-    std::unique_ptr<NodeList> getElementsByClassName(const std::string& className) const {
-        collection_.clean();
-        if(!isElementNode(node_) || !hasChildElements(node_)) return nullptr;
-        auto* element = lxb_dom_interface_element(node_);
-        const lxb_char_t * name = reinterpret_cast<const lxb_char_t *>(className.c_str());
-        lxb_status_t status = lxb_dom_elements_by_class_name(element, collection_.get(), name, className.length());
-        if (status != LXB_STATUS_OK) {
-            throw std::runtime_error("Failed to collect child elements by tag name");
+    std::unique_ptr<NodeList> getElementsByClassName(const std::string& className) const;
+
+    std::unique_ptr<NodeList> getElementsByTagName(const std::string& className) const;
+
+    std::unique_ptr<NodeList> getElementsByAttribute(const std::string& key, const std::string& value) const;
+
+    // The first element below this one that matches a CSS selector list such as "main p.text > a[href]", or a null
+    // Node. Selector text is compiled once per process and kept in SelectorCache::global(); text lexbor cannot parse
+    // throws.
+    Node querySelector(const std::string& selectors) const;
+
+    // Every element below this one that matches, in document order, found in a single walk of the subtree. Unlike
+    // the getElementsBy* lists, empty elements such as <img> or <meta> are kept; ":empty" selects them on purpose.
+    std::unique_ptr<NodeList> querySelectorAll(const std::string& selectors) const;
+
+    std::unique_ptr<std::vector<std::string>> getLinksMatching(const std::string& pattern = "") const;
+
+private:
+    lxb_dom_node_t* node_ {nullptr};
+};
+
+// The elements of a range that satisfy `Pred`, found as the range is walked. Views nest: filter() on a view
+// gives a view that checks both predicates.
+template<typename Range, typename Pred>
+class FilteredRange {
+    Range range;
+    Pred pred;
+
+public:
+    class iterator {
+        typename Range::iterator it, last;
+        const Pred* pred;
+
+        void skip() {
+            while (it != last && !(*pred)(*it)) ++it;
         }
-        return std::make_unique<NodeList>(collection_, document_);
-    }
 
-    std::unique_ptr<NodeList> getElementsByTagName(const std::string& className) const {
-        collection_.clean();
-        if(!isElementNode(node_) || !hasChildElements(node_)) return nullptr;
-        auto* element = lxb_dom_interface_element(node_);
-        const lxb_char_t * name = reinterpret_cast<const lxb_char_t *>(className.c_str());
-        lxb_status_t status = lxb_dom_elements_by_tag_name(element, collection_.get(), name, className.length());
-        if (status != LXB_STATUS_OK) {
-            throw std::runtime_error("Failed to collect child elements by tag name");
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node*;
+        using reference = Node;
+
+        iterator(typename Range::iterator first, typename Range::iterator last, const Pred* pred) : it(first), last(last), pred(pred) {
+            skip();
+        }
+
+        Node operator*() const noexcept { return *it; }
+
+        iterator& operator++() {
+            ++it;
+            skip();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
         }
-        return std::make_unique<NodeList>(collection_, document_);
+
+        bool operator==(const iterator& other) const noexcept { return it == other.it; }
+        bool operator!=(const iterator& other) const noexcept { return it != other.it; }
+    };
+
+    FilteredRange(Range range, Pred pred) : range(range), pred(std::move(pred)) {}
+
+    iterator begin() const { return iterator(range.begin(), range.end(), &pred); }
+    iterator end() const { return iterator(range.end(), range.end(), &pred); }
+
+    // The first match, or a null Node.
+    Node first() const {
+        const auto it = begin();
+        return it != end() ? *it : Node();
     }
 
-    std::unique_ptr<NodeList> getElementsByAttribute(const std::string& key, const std::string& value) const {
-        collection_.clean();
-        if(!isElementNode(node_) || !hasChildElements(node_)) return nullptr;
-        auto* element = lxb_dom_interface_element(node_);
-        const lxb_char_t * name = reinterpret_cast<const lxb_char_t *>(key.c_str());
-        const lxb_char_t * val = reinterpret_cast<const lxb_char_t *>(value.c_str());
-        lxb_status_t status = lxb_dom_elements_by_attr(element, collection_.get(), name, key.length(), val, value.length(), true);
-        if (status != LXB_STATUS_OK) {
-            throw std::runtime_error("Failed to collect child elements by tag name");
+    template<typename Next>
+    auto filter(Next next) const {
+        auto both = [pred = pred, next = std::move(next)](const Node n){ return pred(n) && next(n); };
+        return FilteredRange<Range, decltype(both)>(range, std::move(both));
+    }
+};
+
+// Walks element children through their sibling links.
+class ChildRange {
+    lxb_dom_node_t* first_;
+
+public:
+    class iterator {
+        lxb_dom_node_t* node;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node*;
+        using reference = Node;
+
+        explicit iterator(lxb_dom_node_t* node = nullptr) noexcept : node(node) {}
+
+        Node operator*() const noexcept { return Node(node); }
+
+        iterator& operator++() noexcept {
+            node = Node::nextElement(lxb_dom_node_next(node));
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++*this;
+            return old;
         }
-        return std::make_unique<NodeList>(collection_, document_);
-    }
-
-    std::unique_ptr<std::vector<std::string>> getLinksMatching(const std::string& pattern = "") const {
-        std::regex regexPattern(pattern);
-        std::vector<std::string> matchingLinks;
-        
-        auto linksNodeList = this->getElementsByTagName("a");
-        if (linksNodeList) {
-            for (std::size_t i = 0; i < linksNodeList->length(); ++i) {
-                auto linkNode = linksNodeList->item(i);
-                if (linkNode) {
-                    std::string url = linkNode->getAttribute("href");
-                    if (pattern.empty() || std::regex_match(url, regexPattern)) {
-                        matchingLinks.push_back(url);
-                    }
+
+        bool operator==(const iterator& other) const noexcept { return node == other.node; }
+        bool operator!=(const iterator& other) const noexcept { return node != other.node; }
+    };
+
+    explicit ChildRange(lxb_dom_node_t* parent) noexcept : first_(parent ? Node::nextElement(lxb_dom_node_first_child(parent)) : nullptr) {}
+
+    iterator begin() const noexcept { return iterator(first_); }
+    iterator end() const noexcept { return iterator(); }
+
+    template<typename Pred>
+    FilteredRange<ChildRange, Pred> filter(Pred pred) const {
+        return FilteredRange<ChildRange, Pred>(*this, std::move(pred));
+    }
+};
+
+// Pre-order walk of the subtree under a root, excluding the root: down through first children, then across
+// to the next sibling, climbing back up through parents when a branch runs out.
+class DescendantRange {
+    lxb_dom_node_t* root_;
+
+public:
+    class iterator {
+        lxb_dom_node_t* root;
+        lxb_dom_node_t* node;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node*;
+        using reference = Node;
+
+        iterator(lxb_dom_node_t* root = nullptr, lxb_dom_node_t* node = nullptr) noexcept : root(root), node(node) {}
+
+        Node operator*() const noexcept { return Node(node); }
+
+        iterator& operator++() noexcept {
+            if (lxb_dom_node_t* child = Node::nextElement(lxb_dom_node_first_child(node))) {
+                node = child;
+                return *this;
+            }
+            while (node != root) {
+                if (lxb_dom_node_t* sibling = Node::nextElement(lxb_dom_node_next(node))) {
+                    node = sibling;
+                    return *this;
                 }
+                node = lxb_dom_node_parent(node);
             }
+            node = nullptr;
+            return *this;
+        }
+
+        iterator operator++(int) noexcept {
+            iterator old = *this;
+            ++*this;
+            return old;
         }
-        return std::make_unique<std::vector<std::string>>(matchingLinks);
+
+        bool operator==(const iterator& other) const noexcept { return node == other.node; }
+        bool operator!=(const iterator& other) const noexcept { return node != other.node; }
+    };
+
+    explicit DescendantRange(lxb_dom_node_t* root) noexcept : root_(root) {}
+
+    iterator begin() const noexcept {
+        return iterator(root_, root_ ? Node::nextElement(lxb_dom_node_first_child(root_)) : nullptr);
     }
 
-private:
-    lxb_dom_node_t* node_;
-    lxb_html_document_t* document_;
-    DomCollection& collection_;
+    iterator end() const noexcept { return iterator(root_, nullptr); }
+
+    template<typename Pred>
+    FilteredRange<DescendantRange, Pred> filter(Pred pred) const {
+        return FilteredRange<DescendantRange, Pred>(*this, std::move(pred));
+    }
 };
 
+inline ChildRange Node::children() const noexcept {
+    return ChildRange(node_);
+}
+
+inline DescendantRange Node::descendants() const noexcept {
+    return DescendantRange(node_);
+}
+
+// Walks the subtree directly, so it leaves any NodeList the caller holds untouched.
+inline std::unique_ptr<std::vector<std::string>> Node::getLinksMatching(const std::string& pattern) const {
+    std::regex regexPattern(pattern);
+    std::vector<std::string> matchingLinks;
+
+    for (const Node link : descendants().filter([](const Node n){ return n.tagName() == "a"; })) {
+        std::string url = link.getAttribute("href");
+        if (pattern.empty() || std::regex_match(url, regexPattern)) {
+            matchingLinks.push_back(url);
+        }
+    }
+    return std::make_unique<std::vector<std::string>>(matchingLinks);
+}
+
+// The NodeList-returning calls are defined there.
+#include "NodeList.hpp"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef NODEARENA
+#define NODEARENA
+
+#include "DomCollection.hpp"
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+// Backing store for the query results of one Document. Each result is a block of node pointers cut from the top
+// of a chunk, so any number of lists can be alive at once without aliasing. A list released while it is still the
+// newest, as nested queries are, gives its space straight back; any other space comes back once no list is alive.
+// The Document is the only owner; lists hold it weakly, so one that outlives its Document never touches it.
+class NodeArena : public std::enable_shared_from_this<NodeArena> {
+public:
+    explicit NodeArena(lxb_html_document_t* document) : scratch(document) {}
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    // Runs one lexbor query (`fill` puts its matches into the collection it is given and returns the status),
+    // then copies the matches out into a block of their own, leaving out empty elements unless `keepEmpty`.
+    // Returns the status, the block and its size.
+    template<typename Fill>
+    std::pair<lxb_dom_node_t**, std::size_t> collect(Fill&& fill, lxb_status_t& status, const bool keepEmpty = false) {
+        scratch.clean();
+        status = fill(scratch.get());
+        const std::size_t found = lxb_dom_collection_length(scratch.get());
+        if (status != LXB_STATUS_OK || found == 0) {
+            scratch.clean();
+            return {nullptr, 0};
+        }
+        lxb_dom_node_t** block = allocate(found);
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < found; ++i) {
+            lxb_dom_node_t* node = lxb_dom_collection_node(scratch.get(), i);
+            if (keepEmpty || !lxb_dom_node_is_empty(node)) block[kept++] = node;
+        }
+        scratch.clean();
+        trim(block + kept, found - kept);
+        if (kept == 0) return {nullptr, 0};
+        ++live;
+        return {block, kept};
+    }
+
+    // Ends a block handed out by collect().
+    void release(lxb_dom_node_t** block, const std::size_t n) noexcept {
+        if (n == 0) return;
+        if (--live == 0) {
+            for (auto& chunk : chunks) chunk.top = 0;
+            current = 0;
+            return;
+        }
+        trim(block, n);
+    }
+
+    // Slots reserved across all chunks, and how many of them hold live results.
+    inline const std::size_t capacity() const noexcept {
+        std::size_t total = 0;
+        for (const auto& chunk : chunks) total += chunk.size;
+        return total;
+    }
+
+    inline const std::size_t used() const noexcept {
+        std::size_t total = 0;
+        for (const auto& chunk : chunks) total += chunk.top;
+        return total;
+    }
+
+private:
+    // Cuts `n` slots from the current chunk, or from the first later chunk with room (chunks past the current one
+    // are always empty), or from a new chunk twice the size of the last.
+    lxb_dom_node_t** allocate(const std::size_t n) {
+        if (current == chunks.size() || chunks[current].size - chunks[current].top < n) {
+            std::size_t next = current == chunks.size() ? current : current + 1;
+            while (next < chunks.size() && chunks[next].size < n) ++next;
+            if (next == chunks.size()) {
+                const std::size_t size = std::max(n, chunks.empty() ? min_chunk : chunks.back().size * 2);
+                chunks.push_back({std::make_unique<lxb_dom_node_t*[]>(size), size, 0});
+            }
+            current = next;
+        }
+        Chunk& chunk = chunks[current];
+        lxb_dom_node_t** block = chunk.slots.get() + chunk.top;
+        chunk.top += n;
+        return block;
+    }
+
+    // Gives back `block` if nothing newer was cut after it.
+    void trim(lxb_dom_node_t** block, const std::size_t n) noexcept {
+        if (n == 0 || current == chunks.size()) return;
+        Chunk& chunk = chunks[current];
+        if (block + n != chunk.slots.get() + chunk.top) return;
+        chunk.top -= n;
+        while (current > 0 && chunks[current].top == 0) --current;
+    }
+
+    struct Chunk {
+        std::unique_ptr<lxb_dom_node_t*[]> slots;
+        std::size_t size;
+        std::size_t top;
+    };
+
+    static constexpr std::size_t min_chunk = 256;
+
+    DomCollection scratch;
+    std::vector<Chunk> chunks;
+    std::size_t current {0};
+    std::size_t live {0};
+};
+
+#endif
\ No newline at end of file
@@ -1,35 +1,126 @@
 #ifndef NODEL
 #define NODEL
 
-#include "DomCollection.hpp"
+#include "Node.hpp"
 #include <vector>
 
+// The result of one query: its own block of node pointers in the Document's arena, fixed when the query ran.
+// Later queries, nested or not, never change it. Its nodes are only valid while the Document is alive, but the
+// list itself may outlive it: destroying it then gives nothing back.
 class NodeList {
-    std::vector<lxb_dom_node_t*> nodePtr;
+    std::weak_ptr<NodeArena> arena_;
+    lxb_dom_node_t** nodes_;
+    std::size_t length_;
 public:
-    NodeList(DomCollection& collection, lxb_html_document_t* document)
-        : collection_(collection), document_(document) {
-            std::size_t len = length();
-            nodePtr.reserve(len); 
-            lxb_dom_node_t* node { nullptr };
-            for(std::size_t i = 0; i < len; ++i){
-                node = lxb_dom_collection_node(collection_.get(), i);
-                if(!lxb_dom_node_is_empty(node)) nodePtr.emplace_back(node);
-            }
-        }
+    class const_iterator {
+        lxb_dom_node_t* const* it;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Node*;
+        using reference = Node;
+
+        explicit const_iterator(lxb_dom_node_t* const* it) noexcept : it(it) {}
+
+        Node operator*() const noexcept { return Node(*it); }
+        const_iterator& operator++() noexcept { ++it; return *this; }
+        const_iterator operator++(int) noexcept { return const_iterator(it++); }
+        bool operator==(const const_iterator& other) const noexcept { return it == other.it; }
+        bool operator!=(const const_iterator& other) const noexcept { return it != other.it; }
+    };
+    using iterator = const_iterator;
+
+    NodeList(NodeArena& arena, lxb_dom_node_t** nodes, const std::size_t length) noexcept
+        : arena_(arena.weak_from_this()), nodes_(nodes), length_(length) {}
+
+    ~NodeList() {
+        if (auto arena = arena_.lock()) arena->release(nodes_, length_);
+    }
+
+    NodeList(const NodeList&) = delete;
+    NodeList& operator=(const NodeList&) = delete;
 
     const std::size_t length() const {
-        return lxb_dom_collection_length(collection_.get());
+        return length_;
     }
 
-    std::unique_ptr<Node> item(const std::size_t index) const {
-        if(index >= nodePtr.size()) return nullptr; 
-        return std::make_unique<Node>(nodePtr.at(index), document_, collection_);
+    // A null Node past the end.
+    Node item(const std::size_t index) const noexcept {
+        if(index >= length_) return Node();
+        return Node(nodes_[index]);
     }
 
-private:
-    DomCollection& collection_;
-    lxb_html_document_t* document_;
+    const_iterator begin() const noexcept { return const_iterator(nodes_); }
+    const_iterator end() const noexcept { return const_iterator(nodes_ + length_); }
 };
 
+inline std::unique_ptr<NodeList> Node::getChildElements() const {
+    if(!hasChildElements(node_)) return nullptr;
+    return getElementsByTagName("*");
+}
+
+template<typename Fill>
+inline std::unique_ptr<NodeList> Node::collect(Fill&& fill, const bool keepEmpty) const {
+    lxb_status_t status = LXB_STATUS_OK;
+    const auto [nodes, length] = arena().collect(std::forward<Fill>(fill), status, keepEmpty);
+    if (status != LXB_STATUS_OK) {
+        throw std::runtime_error("Failed to collect child elements");
+    }
+    return std::make_unique<NodeList>(arena(), nodes, length);
+}
+
+inline std::unique_ptr<NodeList> Node::getElementsByClassName(const std::string& className) const {
+    if(!isElementNode(node_) || !hasChildElements(node_)) return nullptr;
+    auto* element = lxb_dom_interface_element(node_);
+    const lxb_char_t * name = reinterpret_cast<const lxb_char_t *>(className.c_str());
+    return collect([&](lxb_dom_collection_t* collection){
+        return lxb_dom_elements_by_class_name(element, collection, name, className.length());
+    });
+}
+
+inline std::unique_ptr<NodeList> Node::getElementsByTagName(const std::string& className) const {
+    if(!isElementNode(node_) || !hasChildElements(node_)) return nullptr;
+    auto* element = lxb_dom_interface_element(node_);
+    const lxb_char_t * name = reinterpret_cast<const lxb_char_t *>(className.c_str());
+    return collect([&](lxb_dom_collection_t* collection){
+        return lxb_dom_elements_by_tag_name(element, collection, name, className.length());
+    });
+}
+
+inline std::unique_ptr<NodeList> Node::getElementsByAttribute(const std::string& key, const std::string& value) const {
+    if(!isElementNode(node_) || !hasChildElements(node_)) return nullptr;
+    auto* element = lxb_dom_interface_element(node_);
+    const lxb_char_t * name = reinterpret_cast<const lxb_char_t *>(key.c_str());
+    const lxb_char_t * val = reinterpret_cast<const lxb_char_t *>(value.c_str());
+    return collect([&](lxb_dom_collection_t* collection){
+        return lxb_dom_elements_by_attr(element, collection, name, key.length(), val, value.length(), true);
+    });
+}
+
+inline Node Node::querySelector(const std::string& selectors) const {
+    const SelectorCache::List list = SelectorCache::global().get(selectors);
+    if(!node_ || !isQueryRoot(node_)) return Node();
+    lxb_dom_node_t* first = nullptr;
+    const lxb_status_t status = SelectorCache::find(node_, list, [&first](lxb_dom_node_t* node){
+        first = node;
+        return LXB_STATUS_STOP;
+    });
+    if (status != LXB_STATUS_OK) {
+        throw std::runtime_error("Failed to match selector");
+    }
+    return Node(first);
+}
+
+inline std::unique_ptr<NodeList> Node::querySelectorAll(const std::string& selectors) const {
+    const SelectorCache::List list = SelectorCache::global().get(selectors);
+    if(!node_ || !isQueryRoot(node_) || !hasChildElements(node_)) return nullptr;
+    return collect([&](lxb_dom_collection_t* collection){
+        return SelectorCache::find(node_, list, [collection](lxb_dom_node_t* node){
+            return lxb_dom_collection_append(collection, node);
+        });
+    }, true);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#ifndef PARSEWP
+#define PARSEWP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <exception>
+
+#include "Parser.hpp"
+#include "../async/AsyncWrapper.hpp"
+
+// Parses response bodies on a fixed set of threads, each with its own lexbor Parser.
+// Payloads are moved in and out, never copied; results are handed back on the loop thread through a uv_async_t.
+template<typename Payload>
+class ParseWorkerPool {
+public:
+    struct Result {
+        std::unique_ptr<Payload> payload;
+        std::unique_ptr<Document> document;
+        std::exception_ptr error;
+    };
+
+    using ResultCallback = std::function<void(Result&)>;
+
+private:
+    std::size_t capacity;
+    std::deque<std::unique_ptr<Payload>> jobs;
+    std::deque<Result> results;
+    std::vector<Result> delivering;
+    std::vector<std::thread> workers;
+    mutable std::mutex jobs_mtx;
+    std::mutex results_mtx;
+    std::condition_variable jobs_cv;
+    std::size_t in_progress {0};
+    bool stopping {false};
+    AsyncWrapper done;
+    ResultCallback on_result;
+
+    void work() {
+        Parser parser;
+        for (;;) {
+            std::unique_ptr<Payload> payload;
+            {
+                std::unique_lock<std::mutex> guard(jobs_mtx);
+                jobs_cv.wait(guard, [this]{ return stopping || !jobs.empty(); });
+                if (stopping) return;
+                payload = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            Result result;
+            try {
+                result.document = std::make_unique<Document>(parser.createDOM(payload->message));
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+            result.payload = std::move(payload);
+
+            {
+                std::lock_guard<std::mutex> guard(results_mtx);
+                results.emplace_back(std::move(result));
+            }
+            done.send();
+        }
+    }
+
+    void deliver() {
+        {
+            std::lock_guard<std::mutex> guard(results_mtx);
+            for (auto& result : results) delivering.emplace_back(std::move(result));
+            results.clear();
+        }
+        for (auto& result : delivering) {
+            {
+                std::lock_guard<std::mutex> guard(jobs_mtx);
+                --in_progress;
+            }
+            if (on_result) on_result(result);
+        }
+        delivering.clear();
+    }
+
+public:
+    ParseWorkerPool(const EventLoop& loop, const std::size_t n, const std::size_t cap, ResultCallback cb) :
+    capacity(cap ? cap : 1),
+    done(loop),
+    on_result(std::move(cb))
+    {
+        done.on<AsyncEvent,AsyncWrapper>([self = this](const AsyncEvent& , AsyncWrapper& wrapper){
+            self->deliver();
+        });
+        done.unref();
+
+        workers.reserve(n ? n : 1);
+        for (std::size_t i = 0; i < (n ? n : 1); ++i) {
+            workers.emplace_back([this]{ work(); });
+        }
+    }
+
+    ParseWorkerPool(const ParseWorkerPool&) = delete;
+    ParseWorkerPool& operator=(const ParseWorkerPool&) = delete;
+
+    ~ParseWorkerPool() {
+        close();
+    }
+
+    // Joins the workers and closes the wakeup handle; queued and undelivered results are dropped.
+    void close() {
+        {
+            std::lock_guard<std::mutex> guard(jobs_mtx);
+            stopping = true;
+        }
+        jobs_cv.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+        done.close();
+    }
+
+    void submit(std::unique_ptr<Payload> payload) {
+        {
+            std::lock_guard<std::mutex> guard(jobs_mtx);
+            jobs.emplace_back(std::move(payload));
+            ++in_progress;
+        }
+        jobs_cv.notify_one();
+    }
+
+    // Queued but not yet picked up by a worker; the caller stops feeding new transfers once this reaches capacity.
+    const bool isFull() const {
+        std::lock_guard<std::mutex> guard(jobs_mtx);
+        return jobs.size() >= capacity;
+    }
+
+    // Submitted and not yet delivered back to the loop.
+    const std::size_t pending() const {
+        std::lock_guard<std::mutex> guard(jobs_mtx);
+        return in_progress;
+    }
+
+    inline const std::size_t workerCount() const noexcept {
+        return workers.size();
+    }
+};
+
+#endif
\ No newline at end of file
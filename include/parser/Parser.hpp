@@ -2,6 +2,8 @@
 #define PARSER
 
 #include "Document.hpp"
+#include <string_view>
+#include <type_traits>
 
 class Parser {
     std::unique_ptr<lxb_html_parser_t, decltype(&lxb_html_parser_destroy)>
@@ -28,6 +30,23 @@ public:
         }
         return Document(std::unique_ptr<lxb_html_document_t, decltype(&lxb_html_document_destroy)>(document_ptr, &lxb_html_document_destroy));
     }
+
+    // Feeds any range of string_view-like chunks (e.g. a response's slab chain) straight to the tokenizer,
+    // so a body never has to be flattened into one string before parsing.
+    template<typename Chunks, typename = std::enable_if_t<!std::is_convertible<const Chunks&, std::string>::value>>
+    Document createDOM(const Chunks& chunks) {
+        std::unique_ptr<lxb_html_document_t, decltype(&lxb_html_document_destroy)> document(
+            lxb_html_parse_chunk_begin(parser.get()), &lxb_html_document_destroy);
+        if (!document) {
+            throw std::runtime_error("Failed to parse HTML");
+        }
+        for (const std::string_view chunk : chunks) {
+            check(lxb_html_parse_chunk_process(parser.get(), reinterpret_cast<const lxb_char_t *>(chunk.data()), chunk.size()),
+                  "Failed to parse HTML chunk");
+        }
+        check(lxb_html_parse_chunk_end(parser.get()), "Failed to parse HTML");
+        return Document(std::move(document));
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#ifndef SELECTORCACHE
+#define SELECTORCACHE
+
+#include <lexbor/css/css.h>
+#include <lexbor/selectors/selectors.h>
+#include <lexbor/dom/interfaces/node.h>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+
+// Compiled CSS selector lists, keyed by their source text and shared by every Document in the process. The least
+// recently used list is dropped once `capacity` are held; a list still being matched on another thread lives until
+// that match ends. Parsing and matching use per-thread lexbor state, so parser workers never contend on anything
+// but the lookup.
+class SelectorCache {
+public:
+    using List = std::shared_ptr<lxb_css_selector_list_t>;
+
+private:
+    using Entry = std::pair<std::string, List>;
+
+    std::list<Entry> order;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::size_t capacity_;
+    uint64_t hits {0};
+    uint64_t misses {0};
+    mutable std::mutex mtx;
+
+    // The lexbor CSS parser and selector matcher are stateful, so each thread keeps its own.
+    struct ThreadState {
+        std::unique_ptr<lxb_css_parser_t, void(*)(lxb_css_parser_t*)> parser {
+            lxb_css_parser_create(), [](lxb_css_parser_t* p){ lxb_css_parser_destroy(p, true); }};
+        std::unique_ptr<lxb_selectors_t, void(*)(lxb_selectors_t*)> selectors {
+            lxb_selectors_create(), [](lxb_selectors_t* s){ lxb_selectors_destroy(s, true); }};
+
+        ThreadState() {
+            if (!parser || lxb_css_parser_init(parser.get(), nullptr) != LXB_STATUS_OK) {
+                throw std::runtime_error("Failed to initialize CSS parser");
+            }
+            if (!selectors || lxb_selectors_init(selectors.get()) != LXB_STATUS_OK) {
+                throw std::runtime_error("Failed to initialize CSS selectors");
+            }
+            // Report each element once, at the first selector of the list it matches.
+            lxb_selectors_opt_set(selectors.get(), LXB_SELECTORS_OPT_MATCH_FIRST);
+        }
+    };
+
+    static ThreadState& thread() {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    template<typename Fn>
+    static lxb_status_t dispatch(lxb_dom_node_t* node, lxb_css_selector_specificity_t, void* ctx) {
+        return (*static_cast<Fn*>(ctx))(node);
+    }
+
+public:
+    explicit SelectorCache(const std::size_t capacity = 256) : capacity_(capacity ? capacity : 1) {}
+
+    SelectorCache(const SelectorCache&) = delete;
+    SelectorCache& operator=(const SelectorCache&) = delete;
+
+    // The cache behind Node::querySelector and friends.
+    static SelectorCache& global() {
+        static SelectorCache cache;
+        return cache;
+    }
+
+    // Parses `selectors` without touching any cache. Throws on text lexbor cannot parse.
+    static List compile(const std::string& selectors) {
+        lxb_css_selector_list_t* list = lxb_css_selectors_parse(thread().parser.get(),
+                                                                reinterpret_cast<const lxb_char_t*>(selectors.c_str()),
+                                                                selectors.length());
+        if (!list) {
+            throw std::runtime_error("Invalid CSS selector: " + selectors);
+        }
+        return List(list, &lxb_css_selector_list_destroy_memory);
+    }
+
+    // The compiled list for `selectors`, parsed on first use. Parsing runs outside the lock; if two threads race on
+    // the same text, the first to finish wins and the other's copy is dropped.
+    List get(const std::string& selectors) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (auto it = index.find(selectors); it != index.end()) {
+                order.splice(order.begin(), order, it->second);
+                ++hits;
+                return it->second->second;
+            }
+            ++misses;
+        }
+        List list = compile(selectors);
+        std::lock_guard<std::mutex> lock(mtx);
+        if (auto it = index.find(selectors); it != index.end()) {
+            order.splice(order.begin(), order, it->second);
+            return it->second->second;
+        }
+        order.emplace_front(selectors, list);
+        index.emplace(selectors, order.begin());
+        while (order.size() > capacity_) {
+            index.erase(order.back().first);
+            order.pop_back();
+        }
+        return list;
+    }
+
+    // Walks the subtree under `root` once, root excluded, calling `fn(node)` for each element that matches `list`
+    // in document order. `fn` returns LXB_STATUS_OK to go on, LXB_STATUS_STOP to end the walk early, or an error.
+    template<typename Fn>
+    static lxb_status_t find(lxb_dom_node_t* root, const List& list, Fn&& fn) {
+        using F = std::remove_reference_t<Fn>;
+        const lxb_status_t status = lxb_selectors_find(thread().selectors.get(), root, list.get(), &dispatch<F>, &fn);
+        return status == LXB_STATUS_STOP ? LXB_STATUS_OK : status;
+    }
+
+    void setCapacity(const std::size_t capacity) {
+        std::lock_guard<std::mutex> lock(mtx);
+        capacity_ = capacity ? capacity : 1;
+        while (order.size() > capacity_) {
+            index.erase(order.back().first);
+            order.pop_back();
+        }
+    }
+
+    const std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return order.size();
+    }
+
+    const uint64_t hitCount() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return hits;
+    }
+
+    const uint64_t missCount() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return misses;
+    }
+};
+
+#endif
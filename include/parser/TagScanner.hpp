@@ -0,0 +1,333 @@
+#ifndef TAGSCANNER
+#define TAGSCANNER
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+struct HtmlAttribute {
+    std::string name;
+    std::string value;
+};
+
+struct HtmlTag {
+    std::string name;
+    std::vector<HtmlAttribute> attributes;
+    bool self_closing {false};
+
+    const std::string* attribute(const std::string_view key) const noexcept {
+        for (const auto& attr : attributes) {
+            if (attr.name == key) return &attr.value;
+        }
+        return nullptr;
+    }
+};
+
+inline char asciiLower(const char c) noexcept {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+inline bool iequals(const std::string_view a, const std::string_view b) noexcept {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (asciiLower(a[i]) != asciiLower(b[i])) return false;
+    }
+    return true;
+}
+
+// Decodes the character references that matter in titles and URLs, in place.
+inline void decodeEntities(std::string& s) {
+    std::size_t amp = s.find('&');
+    if (amp == std::string::npos) return;
+
+    static constexpr struct { std::string_view name; char ch; } named[] {
+        {"amp;", '&'}, {"lt;", '<'}, {"gt;", '>'}, {"quot;", '"'}, {"apos;", '\''}, {"nbsp;", ' '}
+    };
+
+    std::size_t out = amp;
+    for (std::size_t i = amp; i < s.size();) {
+        if (s[i] != '&') { s[out++] = s[i++]; continue; }
+        const std::string_view rest(s.data() + i + 1, s.size() - i - 1);
+        bool replaced = false;
+
+        if (!rest.empty() && rest[0] == '#') {
+            const bool hex = rest.size() > 1 && (rest[1] == 'x' || rest[1] == 'X');
+            std::size_t j = hex ? 2 : 1;
+            uint32_t cp = 0;
+            const std::size_t digits_from = j;
+            for (; j < rest.size() && j < digits_from + 7; ++j) {
+                const char c = rest[j];
+                int d = (c >= '0' && c <= '9') ? c - '0' : -1;
+                if (hex && d < 0 && asciiLower(c) >= 'a' && asciiLower(c) <= 'f') d = asciiLower(c) - 'a' + 10;
+                if (d < 0) break;
+                cp = cp * (hex ? 16 : 10) + static_cast<uint32_t>(d);
+            }
+            if (j > digits_from && cp && cp <= 0x10FFFF) {
+                if (j < rest.size() && rest[j] == ';') ++j;
+                if (cp < 0x80) {
+                    s[out++] = static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    s[out++] = static_cast<char>(0xC0 | (cp >> 6));
+                    s[out++] = static_cast<char>(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    s[out++] = static_cast<char>(0xE0 | (cp >> 12));
+                    s[out++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    s[out++] = static_cast<char>(0x80 | (cp & 0x3F));
+                } else {
+                    s[out++] = static_cast<char>(0xF0 | (cp >> 18));
+                    s[out++] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    s[out++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    s[out++] = static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                i += 1 + j;
+                replaced = true;
+            }
+        } else {
+            for (const auto& entity : named) {
+                if (rest.compare(0, entity.name.size(), entity.name) == 0) {
+                    s[out++] = entity.ch;
+                    i += 1 + entity.name.size();
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (!replaced) s[out++] = s[i++];
+    }
+    s.resize(out);
+}
+
+// An incremental HTML tag scanner: feed() it bytes in chunks of any size and it reports start tags
+// (with attributes), end tags, and the text of raw-text elements (title, script, style, textarea).
+// No tree is built and ordinary text is skipped, so it costs little more than a memchr over the body.
+// Handler must provide:
+//   bool onStartTag(const HtmlTag&)             -- return true to receive the element's text, if raw
+//   void onText(std::string_view element, std::string_view text)
+//   void onEndTag(std::string_view name)
+class TagScanner {
+    enum class State { Data, TagOpen, MarkupOpen, Comment, Declaration, Tag, RawText };
+
+    static constexpr std::size_t max_tag_bytes = 16 * 1024;
+    static constexpr std::size_t max_text_bytes = 1024 * 1024;
+
+    State state {State::Data};
+    std::string buf;
+    char quote {0};
+    char last {0};
+    std::size_t dashes {0};
+
+    std::string raw_close;
+    std::size_t raw_match {0};
+    bool capturing {false};
+    std::string text;
+
+    HtmlTag tag;
+
+    static bool isSpace(const char c) noexcept {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+
+    static bool isAlpha(const char c) noexcept {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    static bool isRawText(const std::string_view name) noexcept {
+        return name == "script" || name == "style" || name == "title" || name == "textarea";
+    }
+
+    void parseTag() {
+        const char* p = buf.data();
+        const char* end = p + buf.size();
+        const bool closing = p < end && *p == '/';
+        if (closing) ++p;
+
+        tag.name.clear();
+        tag.attributes.clear();
+        tag.self_closing = false;
+        while (p < end && !isSpace(*p) && *p != '/') tag.name.push_back(asciiLower(*p++));
+
+        if (closing) return;
+
+        while (p < end) {
+            while (p < end && (isSpace(*p) || *p == '/')) {
+                if (*p == '/' && p + 1 == end) tag.self_closing = true;
+                ++p;
+            }
+            if (p == end) break;
+
+            HtmlAttribute attr;
+            while (p < end && !isSpace(*p) && *p != '=' && *p != '/') attr.name.push_back(asciiLower(*p++));
+            while (p < end && isSpace(*p)) ++p;
+            if (p < end && *p == '=') {
+                ++p;
+                while (p < end && isSpace(*p)) ++p;
+                if (p < end && (*p == '"' || *p == '\'')) {
+                    const char q = *p++;
+                    const char* close = static_cast<const char*>(std::memchr(p, q, end - p));
+                    if (!close) close = end;
+                    attr.value.assign(p, close);
+                    p = close < end ? close + 1 : end;
+                } else {
+                    const char* start = p;
+                    while (p < end && !isSpace(*p)) ++p;
+                    attr.value.assign(start, p);
+                }
+                decodeEntities(attr.value);
+            }
+            if (!attr.name.empty()) tag.attributes.emplace_back(std::move(attr));
+        }
+    }
+
+    template<typename Handler>
+    void emitTag(Handler& handler) {
+        const bool closing = !buf.empty() && buf[0] == '/';
+        parseTag();
+        buf.clear();
+        state = State::Data;
+        if (tag.name.empty()) return;
+
+        if (closing) {
+            handler.onEndTag(tag.name);
+            return;
+        }
+        const bool wants_text = handler.onStartTag(tag);
+        if (isRawText(tag.name)) {
+            raw_close.assign("</").append(tag.name);
+            raw_match = 0;
+            capturing = wants_text;
+            text.clear();
+            state = State::RawText;
+        }
+    }
+
+    void keepText(const char* p, const std::size_t n) {
+        if (capturing && text.size() < max_text_bytes) text.append(p, std::min(n, max_text_bytes - text.size()));
+    }
+
+public:
+    void reset() noexcept {
+        state = State::Data;
+        buf.clear();
+        text.clear();
+        quote = last = 0;
+        dashes = raw_match = 0;
+        capturing = false;
+    }
+
+    template<typename Handler>
+    void feed(const char* p, const std::size_t n, Handler& handler) {
+        const char* end = p + n;
+        while (p < end) {
+            switch (state) {
+                case State::Data: {
+                    const char* lt = static_cast<const char*>(std::memchr(p, '<', end - p));
+                    if (!lt) return;
+                    p = lt + 1;
+                    state = State::TagOpen;
+                    break;
+                }
+                case State::TagOpen: {
+                    const char c = *p;
+                    if (c == '!') {
+                        dashes = 0;
+                        state = State::MarkupOpen;
+                        ++p;
+                    } else if (c == '?') {
+                        state = State::Declaration;
+                        ++p;
+                    } else if (c == '/' || isAlpha(c)) {
+                        buf.clear();
+                        quote = last = 0;
+                        state = State::Tag;
+                    } else {
+                        state = State::Data;
+                    }
+                    break;
+                }
+                case State::MarkupOpen: {
+                    if (*p == '-' && ++dashes == 2) {
+                        dashes = 0;
+                        state = State::Comment;
+                        ++p;
+                    } else if (*p == '-') {
+                        ++p;
+                    } else {
+                        state = State::Declaration;
+                    }
+                    break;
+                }
+                case State::Comment: {
+                    const char c = *p++;
+                    if (c == '>' && dashes >= 2) state = State::Data;
+                    else dashes = (c == '-') ? dashes + 1 : 0;
+                    break;
+                }
+                case State::Declaration: {
+                    const char* gt = static_cast<const char*>(std::memchr(p, '>', end - p));
+                    if (!gt) return;
+                    p = gt + 1;
+                    state = State::Data;
+                    break;
+                }
+                case State::Tag: {
+                    const char* start = p;
+                    bool closed = false;
+                    for (; p < end; ++p) {
+                        const char c = *p;
+                        if (quote) {
+                            if (c == quote) quote = 0;
+                        } else if ((c == '"' || c == '\'') && last == '=') {
+                            quote = c;
+                        } else if (c == '>') {
+                            closed = true;
+                            break;
+                        }
+                        if (!isSpace(c)) last = c;
+                    }
+                    if (buf.size() < max_tag_bytes) buf.append(start, std::min<std::size_t>(p - start, max_tag_bytes - buf.size()));
+                    if (closed) {
+                        ++p;
+                        emitTag(handler);
+                    }
+                    break;
+                }
+                case State::RawText: {
+                    if (raw_match == 0) {
+                        const char* lt = static_cast<const char*>(std::memchr(p, '<', end - p));
+                        if (!lt) {
+                            keepText(p, end - p);
+                            return;
+                        }
+                        keepText(p, lt - p);
+                        p = lt + 1;
+                        raw_match = 1;
+                        break;
+                    }
+                    const char c = *p;
+                    if (asciiLower(c) == raw_close[raw_match]) {
+                        ++p;
+                        if (++raw_match == raw_close.size()) {
+                            const std::string_view element(raw_close.data() + 2, raw_close.size() - 2);
+                            if (capturing) handler.onText(element, text);
+                            text.clear();
+                            capturing = false;
+                            raw_match = 0;
+                            buf.assign("/").append(element);
+                            quote = last = 0;
+                            state = State::Tag;
+                        }
+                    } else {
+                        keepText(raw_close.data(), raw_match);
+                        raw_match = 0;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+};
+
+#endif
\ No newline at end of file
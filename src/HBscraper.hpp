@@ -6,6 +6,9 @@
 #include <vector>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
+#include <atomic>
+#include <optional>
 
 #include "../include/async/EventLoop.hpp"
 #include "../include/async/TimerWrapper.hpp"
@@ -13,27 +16,107 @@
 #include "../include/async/IdleWrapper.hpp"
 #include "../include/async/PrepareWrapper.hpp"
 #include "../include/async/PollWrapper.hpp"
+#include "../include/async/PollPool.hpp"
+#include "../include/async/AsyncWrapper.hpp"
+#include "../include/async/WorkWrapper.hpp"
+#include "../include/async/GetAddrInfoWrapper.hpp"
 
 #include "../include/net/CurlHandlePool.hpp"
 #include "../include/net/CurlMultiWrapper.hpp"
 #include "../include/net/URLRequestManager.hpp"
+#include "../include/net/Checkpoint.hpp"
+#include "../include/net/ResponseCache.hpp"
+#include "../include/net/DnsCache.hpp"
+#include "../include/net/ConcurrencyController.hpp"
+#include "../include/net/RetryPolicy.hpp"
 
 #include "../include/parser/Document.hpp"
 #include "../include/parser/Parser.hpp"
+#include "../include/parser/ParseWorkerPool.hpp"
+#include "../include/parser/ChunkParser.hpp"
+#include "../include/parser/Extractor.hpp"
 
 
+class ShardedAsync;
+
+// What happens to a body as it arrives: buffered and parsed at the end, parsed chunk by chunk,
+// or only scanned by extractors.
+enum class BodyMode { Buffered, Streaming, Extracting };
+
 class Async{
+    friend class ShardedAsync;
+
     std::size_t curl_pool_sz , curl_buf_sz;
     int delay_exit { 0 };
     long total_connection , total_host_connection , timeout; 
-    EventLoop loop { };
-    CheckWrapper idler { loop };
+    EventLoop loop;
+    PrepareWrapper refiller { loop };
+    bool running { false };
     TimerWrapper timer { loop };
     TimerWrapper delay_timer { loop };
-    URLRequestManager url_manager {};
+    TimerWrapper ready_timer { loop };
+    uint64_t ready_due { 0 };
+    AsyncWrapper waker { loop };
+    TimerWrapper checkpoint_timer { loop };
+    WorkWrapper checkpoint_work { loop };
+    std::shared_ptr<CheckpointStore> checkpoint;
+    CrawlJournal checkpoint_batch;
+    std::exception_ptr checkpoint_error;
+    bool checkpoint_final { false };
+    // Delivered 200s waiting to be written to the response cache, which one pool job at a time does in batches.
+    struct CacheWrite {
+        std::string url;
+        std::string etag;
+        std::string last_modified;
+        std::string content_type;
+        ChunkChain body;
+    };
+    WorkWrapper cache_work { loop };
+    std::vector<CacheWrite> cache_queue;
+    std::vector<CacheWrite> cache_batch;
+    std::exception_ptr cache_error;
+    // 304s waiting for their cached body, read in batches on a pool thread of their own; each transfer is
+    // delivered and completed from there.
+    struct CacheRead {
+        std::string url;
+        Request request;
+        std::unique_ptr<CurlEasyHandle::Response> response;
+        std::optional<ResponseCache::Entry> entry;
+        std::exception_ptr error;
+    };
+    WorkWrapper cache_read_work { loop };
+    std::vector<CacheRead> cache_reads;
+    std::vector<CacheRead> cache_read_batch;
+    std::shared_ptr<URLRequestManager> url_manager;
+    std::size_t active { 0 };
+    // Kept per transfer so a failed one can be queued again as it was, in the place it had in the order.
+    struct Transfer {
+        Request request;
+        URLRequestManager::Key key;
+    };
+    std::unordered_map<CurlEasyHandle*, Transfer> transfers;
+    std::function<void()> on_frontier_change;
+    // Called on this loop's thread when it queued a URL it has no free handle for; see ShardedAsync.
+    std::function<void()> on_work_added;
+    // Set while this loop has free handles but the frontier had nothing ready for it; `idle_count`, if shared
+    // with other loops, counts those that are.
+    std::atomic<bool> idle { false };
+    std::atomic<std::size_t>* idle_count { nullptr };
     CurlHandlePool pool;
+    std::shared_ptr<const OptionProfile> profile { std::make_shared<OptionProfile>() };
+    PollPool polls { loop };
     CurlMultiWrapper multi;
     Parser parser {};
+    std::unique_ptr<ParseWorkerPool<CurlEasyHandle::Response>> parse_pool;
+    BodyMode body_mode { BodyMode::Buffered };
+    bool stream_keep_body { true };
+    std::shared_ptr<ResponseCache> cache;
+    std::shared_ptr<DnsCache> dns;
+    std::shared_ptr<ConcurrencyController> controller;
+    std::shared_ptr<RetryPolicy> retry_policy;
+    std::vector<std::unique_ptr<GetAddrInfoWrapper>> resolvers;
+    std::vector<std::string> new_hosts;
+    std::vector<std::unique_ptr<Extractor>> extractors;
     bool print_req_info { true };
     std::ostream* out { &std::cout };
 
@@ -41,11 +124,58 @@ class Async{
     using Fclb = std::function<void(const CurlEasyHandle::Response& response , Async&)>;
     using Iclb = std::function<void(long pending , Async&)>;
     using Eclb = std::function<void(const std::exception& e , Async&)>;
+    using Xclb = std::function<void(const CurlEasyHandle::Response& response , Async& , const ExtractorSet&)>;
 
     Eclb onExceptionclb;
     Sclb onSuccessclb;
     Fclb onFailureclb;
     Iclb onIdleclb;
+    Xclb onExtractedclb;
+
+    // Feeds a handle's body into its own chunk parser while the transfer is still running.
+    struct StreamingSink final : BodySink {
+        ChunkParser parser;
+        std::exception_ptr error;
+
+        bool write(const char* ptr, std::size_t len) noexcept override {
+            try {
+                parser.feed(ptr, len);
+                return true;
+            } catch (...) {
+                error = std::current_exception();
+                parser.abort();
+                return false;
+            }
+        }
+
+        void reset() noexcept override {
+            parser.abort();
+            error = nullptr;
+        }
+    };
+
+    // Scans a handle's body with its extractors and stops the download once they are all satisfied.
+    struct ExtractingSink final : BodySink {
+        ExtractorSet set;
+        std::exception_ptr error;
+
+        explicit ExtractingSink(const std::vector<std::unique_ptr<Extractor>>& prototypes) : set(prototypes) {}
+
+        bool write(const char* ptr, std::size_t len) noexcept override {
+            try {
+                set.feed(ptr, len);
+                return !set.done();
+            } catch (...) {
+                error = std::current_exception();
+                return false;
+            }
+        }
+
+        void reset() noexcept override {
+            set.reset();
+            error = nullptr;
+        }
+    };
 
     static int timeout_function(CURLM *multi, long timeout_ms, void *userp) {
         auto self = static_cast<Async*>(userp);
@@ -61,12 +191,73 @@ class Async{
         if(self->onSuccessclb) self->onSuccessclb(response, *self, dom);     
     }
 
+    void reportException(const std::exception_ptr& error){
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            if(onExceptionclb) onExceptionclb(e, *this);
+        }
+    }
+
+    void processParsedRequest(ParseWorkerPool<CurlEasyHandle::Response>::Result& result){
+        if (result.error) {
+            reportException(result.error);
+        } else if(onSuccessclb) {
+            onSuccessclb(*result.payload, *this, *result.document);
+        }
+        if (result.payload) queueCacheWrite(*result.payload);
+        completeURL();
+    }
+
     static void processFailedRequest(const CurlEasyHandle::Response& response , CURLMsg *m , Async* self){
         const std::string message ("Connection failure (" + std::string(curl_easy_strerror(m->data.result)) + "): " + response.url);
         *(self->out) << message << '\n';
         if(self->onFailureclb) self->onFailureclb(response, *self);
     }
 
+    // The document was built while the body arrived; all that is left is closing the parse. Returns false when
+    // a cache read delivers and completes the transfer later.
+    static const bool processStreamedRequest(CurlEasyHandle& handle, Request& request, CURLMsg *m, Async* self){
+        auto* sink = static_cast<StreamingSink*>(handle.getBodySink());
+        auto response = handle.takeResponse();
+        bool finished = true;
+        if (sink->error) {
+            self->reportException(sink->error);
+        } else if (m->data.result != CURLE_OK) {
+            processFailedRequest(*response, m, self);
+        } else if (self->applyCache(handle, request, response)) {
+            finished = false;
+        } else if (response->responseCode == 200) {
+            std::unique_ptr<Document> dom;
+            try {
+                dom = std::make_unique<Document>(sink->parser.finish());
+            } catch (...) {
+                sink->reset();
+                self->reportException(std::current_exception());
+                return true;
+            }
+            if(self->onSuccessclb) self->onSuccessclb(*response, *self, *dom);
+            self->queueCacheWrite(*response);
+        }
+        sink->reset();
+        return finished;
+    }
+
+    // An aborted write is how a satisfied extractor set ends the transfer, so it counts as success here.
+    static void processExtractedRequest(CurlEasyHandle& handle, CURLMsg *m, Async* self){
+        auto* sink = static_cast<ExtractingSink*>(handle.getBodySink());
+        auto response = handle.response();
+        const bool complete = m->data.result == CURLE_OK || (m->data.result == CURLE_WRITE_ERROR && sink->set.done());
+        if (sink->error) {
+            self->reportException(sink->error);
+        } else if (!complete) {
+            processFailedRequest(*response, m, self);
+        } else if (response->responseCode == 200 && self->onExtractedclb) {
+            self->onExtractedclb(*response, *self, sink->set);
+        }
+        sink->reset();
+    }
+
     static void process_curl(Async* self){
         CURLMsg *message = nullptr;
         int pending = 0;
@@ -75,72 +266,487 @@ class Async{
             if( message->msg == CURLMSG_DONE){   
                 curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &ctx);
                 std::unique_ptr<CurlEasyHandle> handle(ctx);
-                auto response = handle->response();
-
-                if(message->data.result == CURLE_OK) processSuccessfulRequest(*response.get(), self);
+                Request request;
+                if (self->releaseHost(handle.get(), message->data.result, request)) {
+                    self->recycle(std::move(handle));
+                    self->completeURL();
+                    continue;
+                }
+
+                if (self->body_mode != BodyMode::Buffered) {
+                    bool finished = true;
+                    if (self->body_mode == BodyMode::Streaming) finished = processStreamedRequest(*handle, request, message, self);
+                    else processExtractedRequest(*handle, message, self);
+                    self->recycle(std::move(handle));
+                    if (finished) self->completeURL();
+                    continue;
+                }
+
+                if (self->parse_pool && message->data.result == CURLE_OK) {
+                    auto response = handle->takeResponse();
+                    const bool reading = self->applyCache(*handle, request, response);
+                    self->recycle(std::move(handle));
+                    if (reading) continue;
+                    if (response->responseCode == 200) self->parse_pool->submit(std::move(response));
+                    else self->completeURL();
+                    continue;
+                }
+
+                auto response = handle->takeResponse();
+
+                if(message->data.result == CURLE_OK) {
+                    if (self->applyCache(*handle, request, response)) {
+                        self->recycle(std::move(handle));
+                        continue;
+                    }
+                    processSuccessfulRequest(*response.get(), self);
+                    self->queueCacheWrite(*response);
+                }
                 else processFailedRequest(*response.get(), message, self);
 
-                self->multi.removeHandle(handle->get());
-                self->pool.release(std::move(handle));  
+                self->recycle(std::move(handle));
+                self->completeURL();
+            }
+        }
+    }
+
+    // Setters never touch handles directly: they publish a modified copy of the profile, which new requests
+    // snapshot and which handles apply on their next acquire, whether idle or in flight right now.
+    template<typename Fn>
+    void updateProfile(Fn&& fn) {
+        auto next = std::make_shared<OptionProfile>(*profile);
+        fn(*next);
+        profile = std::move(next);
+    }
+
+    void resetProfile() {
+        profile = std::make_shared<OptionProfile>();
+    }
+
+    // Creates or reopens the checkpoint in `dir` and starts journaling `frontier` into it.
+    static std::shared_ptr<CheckpointStore> openCheckpoint(URLRequestManager& frontier , const std::string& dir , const bool resume , std::size_t& resumed) {
+        auto store = std::make_shared<CheckpointStore>(dir);
+        frontier.startJournal();
+        resumed = 0;
+        if (resume && store->open()) resumed = frontier.restore(*store);
+        else store->start();
+        return store;
+    }
+
+    void attachCheckpoint(std::shared_ptr<CheckpointStore> store , const uint64_t interval_ms) {
+        checkpoint = std::move(store);
+        if (interval_ms) checkpoint_timer.start(interval_ms, interval_ms);
+    }
+
+    // Hands what changed since the last checkpoint to a pool thread. While one is still being written the changes
+    // keep piling up for the next. A failed write is reported through onException and ends checkpointing, since
+    // the logs would no longer line up with the journal.
+    void saveCheckpoint() {
+        if (!checkpoint || checkpoint_work.isBusy()) return;
+        {
+            auto guard = url_manager->lock();
+            checkpoint_batch = url_manager->takeJournal();
+        }
+        if (checkpoint_batch.empty()) return;
+        checkpoint_work.queue([self = this]{
+            try {
+                self->checkpoint->write(self->checkpoint_batch);
+            } catch (...) {
+                self->checkpoint_error = std::current_exception();
+            }
+        }, [self = this](int){
+            self->checkpoint_batch.clear();
+            if (self->checkpoint_error) {
+                const auto error = self->checkpoint_error;
+                self->checkpoint_error = nullptr;
+                self->checkpoint.reset();
+                if (self->checkpoint_timer.isActive()) self->checkpoint_timer.stop();
+                return self->reportException(error);
             }
+            if (self->checkpoint_final) self->saveCheckpoint();
+        });
+    }
+
+    // Only bodies that are kept can be cached, so extraction and streaming without a kept body skip the cache.
+    const bool caching() const noexcept {
+        return cache && (body_mode == BodyMode::Buffered || (body_mode == BodyMode::Streaming && stream_keep_body));
+    }
+
+    static const bool isCacheable(const Request& request) noexcept {
+        return (request.method().empty() || request.method() == "GET") && request.body().empty();
+    }
+
+    // Marks a 200 to be stored once delivered. A 304 is queued for readCache along with `request`, and true returned:
+    // the transfer is then delivered, or queued again if the cached copy has gone missing, once the copy is read.
+    const bool applyCache(CurlEasyHandle& handle , Request& request , std::unique_ptr<CurlEasyHandle::Response>& response) {
+        if (!caching()) return false;
+        if (response->responseCode == 200 && response->httpMethod == "GET") {
+            response->cacheUrl = handle.getUrl();
+            return false;
         }
+        if (response->responseCode != 304) return false;
+        if (request.url.empty()) request = Request(handle.getUrl(), handle.getDepth(), profile);
+        cache_reads.push_back(CacheRead{handle.getUrl(), std::move(request), std::move(response), std::nullopt, nullptr});
+        readCache();
+        return true;
+    }
+
+    // Reads the cached bodies of every queued 304 on a pool thread, so the opens and reads never stall the loop's
+    // sockets. 304s arriving meanwhile go in the next batch.
+    void readCache() {
+        if (cache_read_work.isBusy() || cache_reads.empty()) return;
+        std::swap(cache_read_batch, cache_reads);
+        cache_read_work.queue([self = this, cache = cache]{
+            for (auto& read : self->cache_read_batch) {
+                try {
+                    read.entry = cache->load(read.url);
+                } catch (...) {
+                    read.error = std::current_exception();
+                }
+            }
+        }, [self = this](int){
+            auto batch = std::move(self->cache_read_batch);
+            self->cache_read_batch.clear();
+            for (auto& read : batch) self->deliverCached(read);
+            self->readCache();
+        });
+    }
+
+    // Turns a 304 into the cached response it confirmed and delivers it as its body mode would have.
+    void deliverCached(CacheRead& read) {
+        if (read.error) reportException(read.error);
+        if (!read.entry) {
+            // addRequest wakes other shards, as for any new URL.
+            read.request.setDedup(false);
+            addRequest(std::move(read.request));
+            return completeURL();
+        }
+        auto& response = *read.response;
+        response.body = std::move(read.entry->body);
+        response.responseCode = 200;
+        response.contentType = std::move(read.entry->content_type);
+        response.fromCache = true;
+        if (parse_pool && body_mode == BodyMode::Buffered) return parse_pool->submit(std::move(read.response));
+        try {
+            // A revalidated body never went through a streaming sink, so it is parsed from the cached copy.
+            Document dom = parser.createDOM(response.message);
+            if(onSuccessclb) onSuccessclb(response, *this, dom);
+        } catch (...) {
+            reportException(std::current_exception());
+        }
+        completeURL();
+    }
+
+    // Moves the body of a delivered response that applyCache marked into the queue for the cache writer. The
+    // loop is done with the response by then, so nothing is copied.
+    void queueCacheWrite(CurlEasyHandle::Response& response) {
+        if (response.cacheUrl.empty() || !cache) return;
+        cache_queue.push_back(CacheWrite{std::move(response.cacheUrl), response.etag, response.lastModified,
+                                         response.contentType, std::move(response.body)});
+        writeCache();
+    }
+
+    // Writes everything queued so far on a pool thread; the file writes, renames and index appends (with the
+    // occasional compaction and fsync) never stall the loop's sockets. Writes queued meanwhile go in the next batch.
+    // A failed write is reported through onException; the rest of the batch is still written.
+    void writeCache() {
+        if (cache_work.isBusy() || cache_queue.empty()) return;
+        std::swap(cache_batch, cache_queue);
+        cache_work.queue([self = this, cache = cache]{
+            for (auto& item : self->cache_batch) {
+                try {
+                    cache->store(item.url, item.etag, item.last_modified, item.content_type, item.body);
+                } catch (...) {
+                    if (!self->cache_error) self->cache_error = std::current_exception();
+                }
+            }
+        }, [self = this](int){
+            self->cache_batch.clear();
+            if (self->cache_error) {
+                const auto error = self->cache_error;
+                self->cache_error = nullptr;
+                self->reportException(error);
+            }
+            self->writeCache();
+        });
+    }
+
+    // Returns true when the transfer failed in a way worth retrying and was queued again; nothing else
+    // hears about that attempt. Otherwise the request that was sent is moved into `finished`.
+    const bool releaseHost(CurlEasyHandle* handle, const CURLcode result, Request& finished) {
+        auto transfer = transfers.extract(handle);
+        std::size_t host_limit = 0;
+        const std::string host = URLRequestManager::hostOf(handle->getUrl());
+        long code = 0;
+        curl_easy_getinfo(handle->get(), CURLINFO_RESPONSE_CODE, &code);
+        if (controller) {
+            double seconds = 0;
+            curl_easy_getinfo(handle->get(), CURLINFO_TOTAL_TIME, &seconds);
+            host_limit = controller->complete(host, seconds, code, result);
+        }
+        int64_t delay = -1;
+        const RetryClass failure = retry_policy && transfer ? RetryPolicy::classify(result, code) : RetryClass::None;
+        if (failure != RetryClass::None) {
+            uint64_t retry_after = 0;
+            // Without curl_easy_header (libcurl before 7.83) Retry-After is not read and the policy's own backoff applies.
+            #if LIBCURL_VERSION_NUM >= 0x075300
+                struct curl_header* header;
+                if (failure == RetryClass::Throttled && curl_easy_header(handle->get(), "Retry-After", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) {
+                    retry_after = RetryPolicy::parseRetryAfter(header->value);
+                }
+            #endif
+            delay = retry_policy->delayMs(failure, transfer.mapped().request.attempt + 1, transfer.mapped().request.method(), retry_after);
+        }
+        {
+            auto guard = url_manager->lock();
+            if (host_limit) url_manager->setHostLimit(host, host_limit);
+            if (delay >= 0) {
+                // The server asked for a pause; nothing else goes to it meanwhile.
+                if (failure == RetryClass::Throttled) url_manager->deferHost(host, static_cast<uint64_t>(delay));
+                Request request = std::move(transfer.mapped().request);
+                ++request.attempt;
+                url_manager->retry(std::move(request), transfer.mapped().key, static_cast<uint64_t>(delay));
+            } else {
+                url_manager->releaseHost(handle->getUrl());
+                if (transfer) finished = std::move(transfer.mapped().request);
+            }
+        }
+        // A loop sharing the controller may be idle after being refused a slot this one just gave back.
+        if (controller && controller->takeStarved() && on_frontier_change) on_frontier_change();
+        return delay >= 0;
+    }
+
+    // Hands a finished transfer's handle back to the pool, which frees a slot for the next one.
+    void recycle(std::unique_ptr<CurlEasyHandle> handle) {
+        multi.removeHandle(handle->get());
+        pool.release(std::move(handle));
+        requestRefill();
+    }
+
+    void completeURL() {
+        --active;
+        bool drained;
+        {
+            auto guard = url_manager->lock();
+            url_manager->markDone();
+            drained = url_manager->isDrained();
+        }
+        requestRefill();
+        if (drained && on_frontier_change) on_frontier_change();
+    }
+
+    const bool isDrained() {
+        auto guard = url_manager->lock();
+        return url_manager->isDrained();
+    }
+
+    // Starts lookups for hosts new to the frontier on whichever resolvers are free. The frontier lock is held, so
+    // a lookup that cannot even start is given up (left to curl) and its error returned for the caller to report
+    // once the lock is released.
+    std::exception_ptr prefetchHosts() {
+        std::string name;
+        int port;
+        for (auto& resolver : resolvers) {
+            if (resolver->isBusy()) continue;
+            for (;;) {
+                new_hosts.clear();
+                url_manager->takeNewHosts(new_hosts, 1);
+                if (new_hosts.empty()) return nullptr;
+                if (DnsCache::target(new_hosts.front(), name, port) && dns->claim(name)) break;
+            }
+            try {
+                resolver->resolve(name, [self = this, cache = dns, name](const int status, const struct addrinfo* results){
+                    self->recordLookup(*cache, name, status, results);
+                });
+            } catch (...) {
+                dns->forget(name);
+                return std::current_exception();
+            }
+        }
+        return nullptr;
+    }
+
+    void recordLookup(DnsCache& cache, const std::string& name, const int status, const struct addrinfo* results) {
+        std::vector<std::string> addresses;
+        char ip[INET6_ADDRSTRLEN];
+        for (const struct addrinfo* ai = status == 0 ? results : nullptr; ai; ai = ai->ai_next) {
+            if (ai->ai_family == AF_INET && uv_ip4_name(reinterpret_cast<const struct sockaddr_in*>(ai->ai_addr), ip, sizeof ip) == 0) {
+                addresses.emplace_back(ip);
+            } else if (ai->ai_family == AF_INET6 && uv_ip6_name(reinterpret_cast<const struct sockaddr_in6*>(ai->ai_addr), ip, sizeof ip) == 0) {
+                addresses.emplace_back(std::string("[") + ip + "]");
+            }
+        }
+        if (!addresses.empty()) cache.recordAddresses(name, std::move(addresses));
+        else if (status == 0 || status == UV_EAI_NONAME || status == UV_EAI_NODATA) cache.recordMissing(name);
+        else cache.forget(name);
+
+        if (!dns) return;
+        std::exception_ptr error;
+        {
+            auto guard = url_manager->lock();
+            error = prefetchHosts();
+        }
+        if (error) reportException(error);
     }
 
     void processURLs() {
-        CurlEasyHandle* handle;
-        while (url_manager.hasURLs() && !pool.isEmpty()) {
-            auto handle = pool.acquire();
-            auto url_pair = url_manager.popURL();
-            handle->setUrl(url_pair.first.c_str() , url_pair.second);
+        const bool can_send = pool.canAcquire() && !(parse_pool && parse_pool->isFull());
+        if (!can_send && !dns) return;
+        auto guard = url_manager->lock();
+        const std::exception_ptr lookup_error = dns ? prefetchHosts() : nullptr;
+        if (!can_send) {
+            guard.unlock();
+            if (lookup_error) reportException(lookup_error);
+            return;
+        }
+        std::vector<std::string> validators;
+        std::string dns_name, dns_seed;
+        int dns_port;
+        bool dropped = false;
+        while (pool.canAcquire() && url_manager->hasReadyURLs() && (!controller || controller->tryAcquire())) {
+            URLRequestManager::Key key;
+            Request request = url_manager->popURL(&key);
+            dns_seed.clear();
+            // Hosts known not to exist never get a handle.
+            if (dns && DnsCache::target(request.url, dns_name, dns_port) &&
+                dns->check(dns_name, dns_port, dns_seed) == DnsCache::State::Dead) {
+                url_manager->releaseHost(request.url);
+                url_manager->markDone();
+                if (controller) controller->release();
+                dropped = true;
+                continue;
+            }
+            if (retry_policy && !request.attempt) retry_policy->deposit();
+            validators.clear();
+            if (caching() && isCacheable(request)) cache->conditionalHeaders(request.url, validators);
+            leaveIdle();
+            auto handle = pool.acquire(request, profile, validators);
+            if (!dns_seed.empty()) handle->addResolve(dns_seed);
+            handle->setUrl(request.url , request.depth);
             CurlEasyHandle* h = handle.release();
             multi.addHandle(h->get());
+            transfers.emplace(h, Transfer{std::move(request), key});
+            ++active;
         }
+
+        if (pool.canAcquire() && !url_manager->hasReadyURLs()) markIdle();
+
+        // Everything left is held back by crawl delays or retry backoffs; wake up when the first is due.
+        const long wait = url_manager->msUntilReady();
+        if (wait >= 0 && pool.canAcquire()) {
+            const uint64_t due = loop.now() + (wait ? wait : 1);
+            if (!ready_timer.isActive() || due < ready_due) {
+                ready_due = due;
+                ready_timer.start(due - loop.now(), 0);
+            }
+        }
+        pool.shrink();
+        const bool drained = dropped && url_manager->isDrained();
+        guard.unlock();
+        if (lookup_error) reportException(lookup_error);
+        if (drained && on_frontier_change) on_frontier_change();
+    }
+
+    void markIdle() noexcept {
+        if (!idle.exchange(true) && idle_count) idle_count->fetch_add(1);
+    }
+
+    // True if the loop was idle; another thread that gets true owns waking it.
+    const bool leaveIdle() noexcept {
+        if (!idle.exchange(false)) return false;
+        if (idle_count) idle_count->fetch_sub(1);
+        return true;
+    }
+
+    // A URL went into the frontier from this loop. If it can start it itself the refill does so; otherwise
+    // someone else has to hear about it.
+    void workAdded() {
+        requestRefill();
+        if (pool.canAcquire()) return;
+        if (on_work_added) on_work_added();
+        else if (on_frontier_change) on_frontier_change();
+    }
+
+    // Hands requests that will never complete (the loop stopped under them) back to the frontier's accounting.
+    void abandonInFlight() {
+        {
+            auto guard = url_manager->lock();
+            for (auto& [handle, transfer] : transfers) url_manager->releaseHost(handle->getUrl(), false);
+            url_manager->markDone(active);
+        }
+        if (controller) controller->release(transfers.size());
+        transfers.clear();
+        active = 0;
+        if (on_frontier_change) on_frontier_change();
     }
 
     static int socket_function(CURL *easy, curl_socket_t s, int action, void *userp, void *socketp) {
         auto self = static_cast<Async*>(userp);
-        PollWrapper* poll = static_cast<PollWrapper*>(socketp);
 
-        if(action == CURL_POLL_REMOVE && poll){
-            poll->close([](PollWrapper* poll){ delete poll; });
-            self->multi.assign(s, nullptr);
+        if(action == CURL_POLL_REMOVE){
+            self->polls.release(s);
             return 0;
         }
 
         const int ev =(action == CURL_POLL_IN) ? UV_READABLE :(action == CURL_POLL_OUT) ? UV_WRITABLE: (action == CURL_POLL_INOUT) ? (UV_READABLE | UV_WRITABLE) : 0;
-        if(!poll && ev){
-            poll = new PollWrapper(self->loop , s);
-            poll->on<PollEvent,PollWrapper>([self](const PollEvent& event, PollWrapper& wrapper){
-                int flags = 0;
-                if(event.status < 0) flags = CURL_CSELECT_ERR;
-                if(!event.status && event.events & UV_READABLE) flags |= CURL_CSELECT_IN;
-                if(!event.status && event.events & UV_WRITABLE) flags |= CURL_CSELECT_OUT;
-
-                self->multi.socketAction(wrapper.getFd() , flags);
-                process_curl(self);
-            });
-
-            self->multi.assign(s , poll);
-        }
-        if (ev) poll->start(ev);
+        if (ev) self->polls.acquire(s)->start(ev);
         return 0;
     }
 
+    // Whatever may let another transfer start (a handle back in the pool, a URL queued, a delay run out, a
+    // parse finished) asks for a refill. However many ask, it runs once, just before the loop next blocks.
+    inline void requestRefill() noexcept {
+        if (running && !refiller.isActive()) refiller.start();
+    }
+
+    void refill() {
+        refiller.stop();
+        processURLs();
+        if(onIdleclb) onIdleclb(multi.getPending() ,*this);
+        if(isDrained()) finish();
+    }
+
+    // Nothing is queued or in flight, so nothing can be added any more: the crawl is over, at once or after
+    // the linger set with setDelayExitMs.
+    void finish() {
+        if (delay_exit <= 0) return closeProcessing();
+        if (!delay_timer.isActive()) delay_timer.start(delay_exit , 0);
+    }
+
     void initDispatchers(){
-         idler.on<CheckEvent,CheckWrapper>([self = this](const CheckEvent& , CheckWrapper& wrapper){
-            self->processURLs(); 
-            if(self->onIdleclb) self->onIdleclb(self->multi.getPending() ,*self);
-            if(!self->url_manager.hasURLs() && self->multi.getPending() == 0 && !self->delay_timer.isActive()) {
-                self->delay_timer.start( 2000 + self->delay_exit , 0);
-            }
+        refiller.on<PrepareEvent,PrepareWrapper>([self = this](const PrepareEvent& , PrepareWrapper& wrapper){
+            self->refill();
         });
 
         delay_timer.on<TimerEvent,TimerWrapper>([self = this](const TimerEvent& , TimerWrapper& wrapper){
-            if(!self->url_manager.hasURLs() && self->multi.getPending() == 0) {
+            if(self->isDrained()) {
                 self->closeProcessing();
             }
         });
 
+        waker.on<AsyncEvent,AsyncWrapper>([self = this](const AsyncEvent& , AsyncWrapper& wrapper){
+            self->requestRefill();
+        });
+
+        ready_timer.on<TimerEvent,TimerWrapper>([self = this](const TimerEvent& , TimerWrapper& wrapper){
+            self->requestRefill();
+        });
+
+        checkpoint_timer.on<TimerEvent,TimerWrapper>([self = this](const TimerEvent& , TimerWrapper& wrapper){
+            self->saveCheckpoint();
+        });
+
+        polls.on([self = this](const PollEvent& event, PollWrapper& wrapper){
+            int flags = 0;
+            if(event.status < 0) flags = CURL_CSELECT_ERR;
+            if(!event.status && event.events & UV_READABLE) flags |= CURL_CSELECT_IN;
+            if(!event.status && event.events & UV_WRITABLE) flags |= CURL_CSELECT_OUT;
+
+            self->multi.socketAction(wrapper.getFd() , flags);
+            process_curl(self);
+        });
+        waker.unref();
+
         timer.on<TimerEvent,TimerWrapper>([self = this](const TimerEvent& , TimerWrapper& wrapper ){
             self->multi.socketAction(CURL_SOCKET_TIMEOUT, 0);
             process_curl(self);
@@ -148,13 +754,14 @@ class Async{
         
     }
 
-public:
-    Async(long tc = 10 , long hc = 10 , std::size_t bz = 1024 , long tm = 50000) :
+    Async(std::shared_ptr<URLRequestManager> frontier , const LoopType type , long tc , long hc , std::size_t bz , long tm) :
     total_connection(tc) ,
     total_host_connection(hc) ,
     curl_pool_sz (tc) , 
     curl_buf_sz(bz) , 
     timeout(tm),
+    loop(type),
+    url_manager(std::move(frontier)),
     multi(tc,hc),
     pool(tc,bz,tm)
     {
@@ -164,8 +771,25 @@ public:
         initDispatchers();
     }
 
+public:
+    Async(long tc = 10 , long hc = 10 , std::size_t bz = 1024 , long tm = 50000) :
+    Async(std::make_shared<URLRequestManager>(), LoopType::Default, tc, hc, bz, tm) {
+        url_manager->setMaxInFlightPerHost(hc);
+    }
+
+    // Starts no more transfers; the loop returns once those in flight are done. Called by itself when the
+    // frontier drains.
     void closeProcessing(){
-        if(idler.isActive()) idler.stop();
+        running = false;
+        if(refiller.isActive()) refiller.stop();
+        if(ready_timer.isActive()) ready_timer.stop();
+        if(delay_timer.isActive()) delay_timer.stop();
+        waker.unref();
+        if (checkpoint) {
+            if (checkpoint_timer.isActive()) checkpoint_timer.stop();
+            checkpoint_final = true;
+            saveCheckpoint();
+        }
     }
 
     Async(const Async&) = delete;
@@ -174,6 +798,23 @@ public:
     Async& operator=(Async&&) = default;
 
     ~Async(){
+        if (parse_pool) parse_pool->close();
+        while (checkpoint_work.isBusy() || cache_work.isBusy() || cache_read_work.isBusy()) loop.run(UV_RUN_ONCE);
+        dns.reset();
+        for (auto& resolver : resolvers) {
+            resolver->cancel();
+            while (resolver->isBusy()) loop.run(UV_RUN_ONCE);
+        }
+        if (loop.ownsLoop()) {
+            refiller.close();
+            timer.close();
+            delay_timer.close();
+            ready_timer.close();
+            checkpoint_timer.close();
+            waker.close();
+            polls.close();
+            loop.run(UV_RUN_NOWAIT);
+        }
         curl_global_cleanup();
     }
 
@@ -183,128 +824,359 @@ public:
 
     void setMultiplexing(bool val){
         multi.setMultiplex(val);
-        pool.propagateMultiplexing(val);
+        updateProfile([&](OptionProfile& p){ p.setMultiplexing(val); });
     }
 
     void setUserAgent(const std::string& ua){
-        pool.propagateUserAgent(ua);
+        updateProfile([&](OptionProfile& p){ p.setUserAgent(ua); });
     }
 
     void setMaxRedirections(const long l){
-        pool.propagateMaxRedirections(l);
+        updateProfile([&](OptionProfile& p){ p.setMaxRedirections(l); });
     }
 
     void setFollowRedirects(bool follow) noexcept {
-        pool.propagateFollowRedirects(follow);
+        updateProfile([&](OptionProfile& p){ p.setFollowRedirects(follow); });
     }
 
     void setReferer(const std::string& referer) noexcept {
-        pool.propagateReferer(referer);
+        updateProfile([&](OptionProfile& p){ p.setReferer(referer); });
     }
 
     void setCookieFile(const std::string& cookieFile) noexcept {
-        pool.propagateCookieFile(cookieFile);
+        updateProfile([&](OptionProfile& p){ p.setCookieFile(cookieFile); });
     }
 
     void setCookieJar(const std::string& cookieJar) noexcept {
-        pool.propagateCookieJar(cookieJar);
+        updateProfile([&](OptionProfile& p){ p.setCookieJar(cookieJar); });
     }
 
     void setCookies(const std::string& ck){
-        pool.propagateCookies(ck);
+        updateProfile([&](OptionProfile& p){ p.setCookies(ck); });
     }
 
     void setVerbose(bool verbose) noexcept {
-        pool.propagateVerbose(verbose);
+        updateProfile([&](OptionProfile& p){ p.setVerbose(verbose); });
     }
 
     void setBearerToken(const std::string& token) noexcept {
-        pool.propagateBearerToken(token);
+        updateProfile([&](OptionProfile& p){ p.setBearerToken(token); });
     }
 
     void setPostFields(const std::string& postFields) noexcept {
-        pool.propagatePostFields(postFields);
+        updateProfile([&](OptionProfile& p){ p.setPostFields(postFields); });
     }
 
     void setInterface(const std::string& inter) noexcept {
-        pool.propagateInterface(inter);
+        updateProfile([&](OptionProfile& p){ p.setInterface(inter); });
+    }
+
+    // CURL_IPRESOLVE_V4 (the default), CURL_IPRESOLVE_V6 or CURL_IPRESOLVE_WHATEVER.
+    void setIPResolve(const long version) noexcept {
+        updateProfile([&](OptionProfile& p){ p.setIPResolve(version); });
     }
 
     void setSSLUsage(bool useSSL) noexcept {
-        pool.propagateSSLUsage(useSSL);
+        updateProfile([&](OptionProfile& p){ p.setSSLUsage(useSSL); });
     }
 
     void setVerify(bool verify) noexcept {
-        pool.propagateVerify(false);
+        updateProfile([&](OptionProfile& p){ p.setVerify(verify); });
     }
 
     void setBasicAuth(const std::string& username, const std::string& password) noexcept {
-        pool.propagateBasicAuth(username,password);
+        updateProfile([&](OptionProfile& p){ p.setBasicAuth(username,password); });
     }
 
     void setDigestAuth(const std::string& username, const std::string& password) noexcept {
-        pool.propagateDigestAuth(username,password);
+        updateProfile([&](OptionProfile& p){ p.setDigestAuth(username,password); });
     }
 
     void setNTLMAuth(const std::string& domain, const std::string& username, const std::string& password) noexcept {
-        pool.propagateNTLMAuth(domain,username,password);
+        updateProfile([&](OptionProfile& p){ p.setNTLMAuth(domain,username,password); });
     }
 
     void setClientCertificate(const std::string& certPath, const std::string& keyPath) noexcept {
-        pool.propagateClientCertificate(certPath,keyPath);
+        updateProfile([&](OptionProfile& p){ p.setClientCertificate(certPath,keyPath); });
     }
 
     void setProxy(const std::string& proxyUrl, int proxyPort = 0) noexcept {
-        pool.propagateProxy(proxyUrl,proxyPort);
+        updateProfile([&](OptionProfile& p){ p.setProxy(proxyUrl,proxyPort); });
     }
 
     void setProxyAuth(const std::string& username, const std::string& password) noexcept {
-        pool.propagateProxyAuth(username,password);
+        updateProfile([&](OptionProfile& p){ p.setProxyAuth(username,password); });
     }
 
     void setLimitMBytesPerSec(double mbytesPerSec) noexcept {
-        pool.propagateLimitMBytesPerSec(mbytesPerSec);
+        updateProfile([&](OptionProfile& p){ p.setLimitMBytesPerSec(mbytesPerSec); });
     }
 
     void setHttpVersion(const HTTP ver){
-        pool.propagateHttpVersion(ver);
+        updateProfile([&](OptionProfile& p){ p.setHttpVersion(ver); });
     }
 
     void setHeader(const std::string& head){
-        pool.propagateHeader(head);
+        updateProfile([&](OptionProfile& p){ p.addHeader(head); });
     }
 
     void setHeaders(const std::vector<std::string>& head){
-        pool.propagateHeaders(head);
+        updateProfile([&](OptionProfile& p){ p.addHeaders(head); });
     }
 
     void clearHeaders(){
-        pool.propogateClearHeaders();
+        updateProfile([&](OptionProfile& p){ p.clearHeaders(); });
     }
 
     void resetPool(){
-        pool.propagateReset();
+        resetProfile();
     }
 
     void forceGetRequests(const bool val){
-        pool.propogateGet(val);
+        updateProfile([&](OptionProfile& p){ p.setGet(val); });
     }
 
     void forcePostRequests(const bool val){
-        pool.propogatePost(val);
+        updateProfile([&](OptionProfile& p){ p.setPost(val); });
     }
 
     void setPoolBufferSize(const std::size_t sz){
-        pool.propogateBufferSize(sz);
+        updateProfile([&](OptionProfile& p){ p.setBufferSize(sz); });
     }
 
     void setConnectionTimeout(const long tm){
-        pool.propogateTimeout(tm);
+        updateProfile([&](OptionProfile& p){ p.setTimeoutMs(tm); });
+    }
+
+    // BreadthFirst/DepthFirst order by depth; BestFirst by `score` (higher first), which sees the URL, host,
+    // depth and the anchor text passed to addURL. Call before seeding.
+    void setFrontierOrder(const FrontierOrder order , URLRequestManager::ScoreFunction score = nullptr){
+        auto guard = url_manager->lock();
+        url_manager->setOrder(order, std::move(score));
+    }
+
+    // Links deeper than this are ignored.
+    void setMaxDepth(const std::size_t depth){
+        auto guard = url_manager->lock();
+        url_manager->setMaxDepth(depth);
+    }
+
+    // Caps how many URLs are ever queued for one host; 0 lifts the cap.
+    void setMaxPagesPerHost(const std::size_t n){
+        auto guard = url_manager->lock();
+        url_manager->setMaxPagesPerHost(n);
+    }
+
+    // Bounds the frontier's memory: past `hot` queued requests the rest are spilled to segment files in `dir`
+    // and read back, ahead of need and off the loop thread, as the in-memory part drains.
+    void setFrontierSpill(const std::string& dir , const std::size_t hot , const std::size_t segment_bytes = 64u << 20){
+        auto guard = url_manager->lock();
+        url_manager->setSpill(dir, hot, segment_bytes, [this]{ waker.send(); });
+    }
+
+    // Keeps GET responses that carry an ETag or Last-Modified in `dir` and revalidates them on the next fetch.
+    // A 304 then reaches onSuccess as the cached response with code 200 and `fromCache` set. Needs the body:
+    // not used with extractors, or with streaming parse unless the body is kept.
+    void enableResponseCache(const std::string& dir){
+        cache = std::make_shared<ResponseCache>(dir);
+    }
+
+    // Shares one cache between loops; null turns caching off.
+    void setResponseCache(std::shared_ptr<ResponseCache> c) noexcept{
+        cache = std::move(c);
+    }
+
+    inline const std::shared_ptr<ResponseCache>& responseCache() const noexcept{
+        return cache;
+    }
+
+    // Shares DNS and TLS session caches (and pins) with every other loop attached to `share`; null detaches.
+    // Handles switch over on their next request.
+    void setShare(std::shared_ptr<CurlShare> share) noexcept{
+        pool.setShare(std::move(share));
+    }
+
+    inline const std::shared_ptr<CurlShare>& share() const noexcept{
+        return pool.getShare();
+    }
+
+    // Sends requests for `host`:`port` to `addresses` without resolving it, e.g. for the few hosts a crawl hits
+    // hardest. Creates a share for this loop if it has none.
+    void pinHost(const std::string& host , const int port , const std::vector<std::string>& addresses){
+        if (!pool.getShare()) pool.setShare(std::make_shared<CurlShare>());
+        pool.getShare()->pin(host, port, addresses);
+    }
+
+    // Resolves hosts as they first reach the frontier, up to `lookups` at a time on libuv's thread pool, so their
+    // first request finds the address already in curl's DNS cache. Hosts that do not exist are remembered for
+    // `negative_ttl_ms` and their URLs dropped before they take a handle (see DnsCache::droppedCount). Call before seeding.
+    void enableDnsPrefetch(const std::size_t lookups = 4 , const uint64_t ttl_ms = 60000 , const uint64_t negative_ttl_ms = 300000){
+        setDnsCache(std::make_shared<DnsCache>(ttl_ms, negative_ttl_ms), lookups);
+    }
+
+    // Prefetches into a cache shared with other loops; null turns prefetching off.
+    void setDnsCache(std::shared_ptr<DnsCache> c , const std::size_t lookups = 4){
+        for (const auto& resolver : resolvers) {
+            if (resolver->isBusy()) throw std::logic_error("Cannot change DNS prefetching while lookups are running");
+        }
+        dns = std::move(c);
+        resolvers.clear();
+        if (dns) {
+            if (!lookups) throw std::invalid_argument("DNS prefetch needs at least one concurrent lookup");
+            for (std::size_t i = 0; i < lookups; ++i) resolvers.emplace_back(std::make_unique<GetAddrInfoWrapper>(loop));
+        }
+        auto guard = url_manager->lock();
+        url_manager->watchHosts(dns != nullptr);
+    }
+
+    inline const std::shared_ptr<DnsCache>& dnsCache() const noexcept{
+        return dns;
+    }
+
+    // Checkpoints the frontier and the visited set into `dir` every `interval_ms`, on a libuv pool thread, and once
+    // more when the crawl ends. Each checkpoint only appends what changed since the last one. With `resume`, a
+    // checkpoint already in `dir` is loaded first: whatever was queued or in flight is queued again and visited
+    // URLs stay visited. Call before seeding; returns the number of requests resumed.
+    std::size_t enableCheckpoints(const std::string& dir , const uint64_t interval_ms = 30000 , const bool resume = false){
+        std::size_t resumed;
+        {
+            auto guard = url_manager->lock();
+            attachCheckpoint(openCheckpoint(*url_manager, dir, resume, resumed), interval_ms);
+        }
+        if (resumed) {
+            requestRefill();
+            if (on_frontier_change) on_frontier_change();
+        }
+        return resumed;
+    }
+
+    // Writes a checkpoint now, without waiting for the interval.
+    void checkpointNow(){
+        saveCheckpoint();
+    }
+
+    // Lets the handle pool float between `min` and `max` handles: it grows while requests are waiting and
+    // drops handles above `min` after `idle_ms` without work. Defaults to a fixed pool of the connection limit.
+    void setPoolLimits(const std::size_t min , const std::size_t max , const uint64_t idle_ms = 30000){
+        pool.setLimits(min, max);
+        pool.setIdleTimeoutMs(idle_ms);
+    }
+
+    inline const std::size_t poolSize() const noexcept{
+        return pool.size();
+    }
+
+    // The option snapshot that addURL() currently attaches to new requests.
+    inline std::shared_ptr<const OptionProfile> currentProfile() const noexcept{
+        return profile;
+    }
+
+    // Minimum gap between two requests to the same host.
+    void setCrawlDelayMs(const uint64_t ms){
+        auto guard = url_manager->lock();
+        url_manager->setCrawlDelayMs(ms);
+    }
+
+    // Requests to one host that may be in flight at once; 0 lifts the cap. Defaults to the per-host connection limit.
+    void setMaxHostRequests(const std::size_t n){
+        auto guard = url_manager->lock();
+        url_manager->setMaxInFlightPerHost(n);
+    }
+
+    // Lets an AIMD controller pick how many transfers run at once, between `min` and `max`, and per host up to
+    // `max_per_host`, from the latency and errors of completed transfers. Raises the handle pool and curl's
+    // connection caps to the maxima. Call before run().
+    void enableAdaptiveConcurrency(const std::size_t min , const std::size_t max , const std::size_t max_per_host){
+        setConcurrencyController(std::make_shared<ConcurrencyController>(min, max, max_per_host, static_cast<std::size_t>(total_connection)));
+    }
+
+    // Shares one controller (and so one overall cap) between loops; null goes back to fixed limits.
+    void setConcurrencyController(std::shared_ptr<ConcurrencyController> c){
+        controller = std::move(c);
+        if (!controller) return;
+        const auto max = std::max(controller->maxLimit(), static_cast<std::size_t>(total_connection));
+        const auto per_host = std::max(controller->maxPerHost(), static_cast<std::size_t>(total_host_connection));
+        multi.setNumConnections(static_cast<long>(max), static_cast<long>(per_host));
+        pool.setLimits(std::min(pool.minSize(), max), max);
+        auto guard = url_manager->lock();
+        url_manager->setMaxInFlightPerHost(controller->maxPerHost());
+    }
+
+    // The controller's current overall figures; zeros when adaptive concurrency is off.
+    ConcurrencyMetrics concurrencyMetrics() const{
+        return controller ? controller->metrics() : ConcurrencyMetrics{};
+    }
+
+    inline const std::shared_ptr<ConcurrencyController>& concurrencyController() const noexcept{
+        return controller;
+    }
+
+    // Retries transfers that failed to connect, timed out, were throttled (429/503, honouring Retry-After) or
+    // hit a 5xx, with jittered exponential backoff and a budget of `budget_ratio` retries per request. Tune the
+    // rules through retryPolicy()->setRule.
+    void enableRetries(const double budget_ratio = 0.1 , const double budget_reserve = 10){
+        retry_policy = std::make_shared<RetryPolicy>(budget_ratio, budget_reserve);
+    }
+
+    // Shares one policy (and so one budget) between loops; null turns retries off.
+    void setRetryPolicy(std::shared_ptr<RetryPolicy> policy) noexcept{
+        retry_policy = std::move(policy);
+    }
+
+    inline const std::shared_ptr<RetryPolicy>& retryPolicy() const noexcept{
+        return retry_policy;
+    }
+
+    // Moves HTML parsing off the loop thread; onSuccess still runs on the loop once the document is ready.
+    // While `queue_capacity` bodies wait for a parser, no new transfers are started. Call before run().
+    void setParseWorkers(const std::size_t workers , const std::size_t queue_capacity = 256){
+        parse_pool.reset();
+        if (workers == 0) return;
+        parse_pool = std::make_unique<ParseWorkerPool<CurlEasyHandle::Response>>(loop, workers, queue_capacity,
+            [self = this](ParseWorkerPool<CurlEasyHandle::Response>::Result& result){
+                self->processParsedRequest(result);
+            });
+    }
+
+    // Parses each body chunk by chunk as curl receives it, so the document is ready when the transfer ends.
+    // With keep_body false, response.message stays empty and the raw body is never buffered.
+    // Takes precedence over setParseWorkers and replaces any extractors. Call before run().
+    void setStreamingParse(const bool enabled , const bool keep_body = true){
+        extractors.clear();
+        body_mode = enabled ? BodyMode::Streaming : BodyMode::Buffered;
+        stream_keep_body = keep_body;
+        if (enabled) pool.propagateBodySink([]{ return std::make_unique<StreamingSink>(); }, keep_body);
+        else pool.propagateBodySink(nullptr);
+    }
+
+    // Switches the crawl to extraction: bodies are only scanned for what the extractors want, and each
+    // download is cut off as soon as all of them are satisfied. No DOM is built and onSuccess is not
+    // called; results arrive through onExtracted. The raw body is not kept. Call before run().
+    void addExtractor(std::unique_ptr<Extractor> prototype){
+        if (!prototype) throw std::invalid_argument("Extractor must not be null");
+        extractors.emplace_back(std::move(prototype));
+        body_mode = BodyMode::Extracting;
+        pool.propagateBodySink([self = this]{ return std::make_unique<ExtractingSink>(self->extractors); }, false);
+    }
+
+    void clearExtractors(){
+        if (body_mode != BodyMode::Extracting) return;
+        extractors.clear();
+        body_mode = BodyMode::Buffered;
+        pool.propagateBodySink(nullptr);
+    }
+
+    // Largest body accepted; with extractors a few KB of head is usually all that is read anyway.
+    void setMaxBodySize(const curl_off_t bytes) noexcept {
+        updateProfile([&](OptionProfile& p){ p.setMaxFileSize(bytes); });
     }
 
     inline void run() {
         try {
-            idler.start();
+            // The waker keeps the loop alive while it waits on nothing but parse workers or other shards.
+            running = true;
+            waker.ref();
+            requestRefill();
             loop.run();
         } catch (const std::exception& e) {
             if(onExceptionclb) {
@@ -316,21 +1188,51 @@ public:
     }
 
     inline void clearQueue(){
-        url_manager.clear();
+        auto guard = url_manager->lock();
+        url_manager->clear();
+    }
+
+    inline const std::size_t pendingUrlsQueueSize() const {
+        auto guard = url_manager->lock();
+        return url_manager->getPendingUrlQueueSize();
+    }
+
+    const bool isVisited(const std::string& url){
+        auto guard = url_manager->lock();
+        return url_manager->isVisited(url);
     }
 
-    inline const std::size_t pendingUrlsQueueSize() const noexcept{
-        return url_manager.getPendingUrlQueueSize();
+    const std::size_t visitedUrlsSize(){
+        auto guard = url_manager->lock();
+        return url_manager->getVisitedUrlSize();
     }
 
-    const std::unordered_set<std::string>& getVisitedUrls(){
-        return url_manager.getVisited();
+    // Sort query parameters before dedup, so ?a=1&b=2 and ?b=2&a=1 count as one URL.
+    void setSortQueryParams(const bool val){
+        auto guard = url_manager->lock();
+        url_manager->canonicalizer().setSortQuery(val);
+    }
+
+    // Query parameters dropped before dedup and fetch; a trailing '*' matches by prefix, e.g. "utm_*".
+    void setStrippedQueryParams(const std::vector<std::string>& keys){
+        auto guard = url_manager->lock();
+        url_manager->canonicalizer().setStrippedParams(keys);
+    }
+
+    // FingerprintSet (exact, default) or BloomFilter (bounded memory). Call before seeding.
+    void setVisitedSet(std::unique_ptr<VisitedSet> set){
+        auto guard = url_manager->lock();
+        url_manager->setVisitedSet(std::move(set));
     }
 
     void onSuccess(const Sclb& clb) noexcept{
         onSuccessclb = clb;
     }
 
+    void onExtracted(const Xclb& clb) noexcept{
+        onExtractedclb = clb;
+    }
+
     void onFailure(const Fclb& clb) noexcept{
         onFailureclb = clb;
     }
@@ -340,7 +1242,7 @@ public:
     }
 
     void resetOptions(){
-        pool.propagateReset();
+        resetProfile();
     }
 
     void onException(const Eclb& clb) noexcept{
@@ -351,16 +1253,40 @@ public:
         onIdleclb = clb;
     }
 
+    // Keeps the loop running this long once the crawl has drained; by default run() returns at once.
     void setDelayExitMs(int ms)  noexcept{
         delay_exit = ms;
     }
 
-    void addURL(const std::string& url,const std::size_t depth){
-        url_manager.addURL(url,depth);
+    // `anchor` is the link's text, used only by a BestFirst score function.
+    void addURL(const std::string& url,const std::size_t depth , const std::string_view anchor = {}){
+        bool added;
+        {
+            auto guard = url_manager->lock();
+            added = url_manager->addURL(url,depth,profile,anchor);
+        }
+        if (added) workAdded();
+    }
+
+    // Queues a request with its own method, body, headers, timeout or priority. It shares this loop's connections
+    // with every other request; without a profile of its own it takes the current one.
+    void addRequest(Request request){
+        if (!request.profile) request.profile = profile;
+        bool added;
+        {
+            auto guard = url_manager->lock();
+            added = url_manager->addRequest(std::move(request));
+        }
+        if (added) workAdded();
     }
 
     void seed(const std::string& url){
-        url_manager.addURL(url,0);
+        addURL(url,0);
+        processURLs();
+    }
+
+    void seed(Request request){
+        addRequest(std::move(request));
         processURLs();
     }
 
@@ -0,0 +1,246 @@
+#ifndef SHARDEDASYNC
+#define SHARDEDASYNC
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
+#include "HBscraper.hpp"
+
+// Runs N independent Async shards, one per thread. Every shard owns its loop, multi handle and handle pool;
+// they share the frontier, so a URL discovered by one shard can be fetched by whichever shard is free first,
+// and a CurlShare, so a host resolved or a TLS session set up by one shard is reused by all of them.
+class ShardedAsync {
+    using Configurator = std::function<void(Async&)>;
+
+    std::size_t shard_count;
+    long total_connection , total_host_connection , timeout;
+    std::size_t curl_buf_sz;
+    std::shared_ptr<URLRequestManager> frontier { std::make_shared<URLRequestManager>() };
+    std::vector<Configurator> configurators;
+    std::shared_ptr<CheckpointStore> checkpoint;
+    std::shared_ptr<ResponseCache> cache;
+    std::shared_ptr<CurlShare> share { std::make_shared<CurlShare>() };
+    std::shared_ptr<DnsCache> dns;
+    std::size_t dns_lookups {0};
+    std::shared_ptr<ConcurrencyController> controller;
+    std::shared_ptr<RetryPolicy> retry_policy;
+    uint64_t checkpoint_ms {0};
+    std::vector<Async*> shards;
+    std::atomic<std::size_t> idle_shards {0};
+    std::mutex shards_mtx;
+    std::mutex lifecycle_mtx;
+
+    // For changes every shard has to see, such as the crawl draining.
+    void wakeShards() {
+        std::lock_guard<std::mutex> guard(shards_mtx);
+        for (auto* shard : shards) {
+            if (shard) shard->waker.send();
+        }
+    }
+
+    // For new work: only shards that last found nothing to start need a nudge, and each gets at most one until
+    // it goes idle again. Busy shards take the work on their next refill.
+    void wakeIdleShards() {
+        if (idle_shards.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> guard(shards_mtx);
+        for (auto* shard : shards) {
+            if (shard && shard->leaveIdle()) shard->waker.send();
+        }
+    }
+
+    void runShard(const std::size_t index) {
+        std::unique_ptr<Async> shard;
+        {
+            // curl_global_init/cleanup are not thread-safe on older libcurl, so shards are built and torn down one at a time.
+            std::lock_guard<std::mutex> guard(lifecycle_mtx);
+            shard.reset(new Async(frontier, LoopType::Private, total_connection, total_host_connection, curl_buf_sz, timeout));
+            shard->setShare(share);
+            for (const auto& configure : configurators) configure(*shard);
+            if (cache) shard->setResponseCache(cache);
+            if (dns) shard->setDnsCache(dns, dns_lookups);
+            if (controller) shard->setConcurrencyController(controller);
+            if (retry_policy) shard->setRetryPolicy(retry_policy);
+            // One shard writes checkpoints for the shared frontier.
+            if (index == 0 && checkpoint) shard->attachCheckpoint(checkpoint, checkpoint_ms);
+            shard->on_frontier_change = [this]{ wakeShards(); };
+            shard->on_work_added = [this]{ wakeIdleShards(); };
+            shard->idle_count = &idle_shards;
+        }
+        {
+            std::lock_guard<std::mutex> guard(shards_mtx);
+            shards[index] = shard.get();
+        }
+
+        std::exception_ptr error;
+        try {
+            shard->run();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(shards_mtx);
+            shards[index] = nullptr;
+            shard->leaveIdle();
+        }
+        shard->abandonInFlight();
+        {
+            std::lock_guard<std::mutex> guard(lifecycle_mtx);
+            shard.reset();
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+public:
+    explicit ShardedAsync(std::size_t n = std::thread::hardware_concurrency() , long tc = 10 , long hc = 10 , std::size_t bz = 1024 , long tm = 50000) :
+    shard_count(n ? n : 1) ,
+    total_connection(tc) ,
+    total_host_connection(hc) ,
+    timeout(tm) ,
+    curl_buf_sz(bz)
+    {
+        frontier->setMaxInFlightPerHost(hc);
+    }
+
+    ShardedAsync(const ShardedAsync&) = delete;
+    ShardedAsync& operator=(const ShardedAsync&) = delete;
+
+    // Applied to every shard on its own thread before it starts; use it for setters and callbacks alike.
+    void configure(const Configurator& fn) {
+        configurators.emplace_back(fn);
+    }
+
+    void setVisitedSet(std::unique_ptr<VisitedSet> set) {
+        auto guard = frontier->lock();
+        frontier->setVisitedSet(std::move(set));
+    }
+
+    // Frontier-wide settings: the frontier is shared, so these apply to every shard at once.
+    void setFrontierOrder(const FrontierOrder order, URLRequestManager::ScoreFunction score = nullptr) {
+        auto guard = frontier->lock();
+        frontier->setOrder(order, std::move(score));
+    }
+
+    // Bounds the shared frontier's memory to about `hot` requests; see Async::setFrontierSpill.
+    void setFrontierSpill(const std::string& dir, const std::size_t hot, const std::size_t segment_bytes = 64u << 20) {
+        auto guard = frontier->lock();
+        frontier->setSpill(dir, hot, segment_bytes, [this]{ wakeShards(); });
+    }
+
+    // One response cache for all shards; see Async::enableResponseCache. Call before run().
+    void enableResponseCache(const std::string& dir) {
+        cache = std::make_shared<ResponseCache>(dir);
+    }
+
+    // See Async::pinHost; pins apply to every shard. Connections stay per shard: curl cannot share them across threads.
+    void pinHost(const std::string& host, const int port, const std::vector<std::string>& addresses) {
+        share->pin(host, port, addresses);
+    }
+
+    // Replaces the caches the shards share, e.g. with one used by other loops too; null gives each shard its own.
+    void setShare(std::shared_ptr<CurlShare> s) noexcept {
+        share = std::move(s);
+    }
+
+    // See Async::enableDnsPrefetch. Every shard resolves up to `lookups` hosts at a time into one shared cache,
+    // and each host is looked up by one shard only. Call before seeding.
+    void enableDnsPrefetch(const std::size_t lookups = 2, const uint64_t ttl_ms = 60000, const uint64_t negative_ttl_ms = 300000) {
+        if (!lookups) throw std::invalid_argument("DNS prefetch needs at least one concurrent lookup");
+        dns = std::make_shared<DnsCache>(ttl_ms, negative_ttl_ms);
+        dns_lookups = lookups;
+        auto guard = frontier->lock();
+        frontier->watchHosts(true);
+    }
+
+    // See Async::enableAdaptiveConcurrency. One controller caps the transfers of all shards together, starting
+    // from the shards' combined connection limit. Call before run().
+    void enableAdaptiveConcurrency(const std::size_t min, const std::size_t max, const std::size_t max_per_host) {
+        controller = std::make_shared<ConcurrencyController>(min, max, max_per_host, shard_count * static_cast<std::size_t>(total_connection));
+    }
+
+    inline const std::shared_ptr<ConcurrencyController>& concurrencyController() const noexcept {
+        return controller;
+    }
+
+    // See Async::enableRetries. Shards share the policy and its budget; a retry may go out from any shard.
+    void enableRetries(const double budget_ratio = 0.1, const double budget_reserve = 10) {
+        retry_policy = std::make_shared<RetryPolicy>(budget_ratio, budget_reserve);
+    }
+
+    inline const std::shared_ptr<RetryPolicy>& retryPolicy() const noexcept {
+        return retry_policy;
+    }
+
+    // See Async::enableCheckpoints; the first shard does the writing. Call before seeding and run().
+    std::size_t enableCheckpoints(const std::string& dir, const uint64_t interval_ms = 30000, const bool resume = false) {
+        auto guard = frontier->lock();
+        std::size_t resumed;
+        checkpoint = Async::openCheckpoint(*frontier, dir, resume, resumed);
+        checkpoint_ms = interval_ms;
+        return resumed;
+    }
+
+    void setMaxDepth(const std::size_t depth) {
+        auto guard = frontier->lock();
+        frontier->setMaxDepth(depth);
+    }
+
+    void setMaxPagesPerHost(const std::size_t n) {
+        auto guard = frontier->lock();
+        frontier->setMaxPagesPerHost(n);
+    }
+
+    void seed(const std::string& url) {
+        auto guard = frontier->lock();
+        frontier->addURL(url, 0);
+    }
+
+    // Without a profile of its own, the request is sent with the options of whichever shard picks it up.
+    void seed(Request request) {
+        auto guard = frontier->lock();
+        frontier->addRequest(std::move(request));
+    }
+
+    void run() {
+        curl_global_init(CURL_GLOBAL_ALL);
+        shards.assign(shard_count, nullptr);
+
+        std::vector<std::exception_ptr> errors(shard_count);
+        std::vector<std::thread> threads;
+        threads.reserve(shard_count);
+        for (std::size_t i = 0; i < shard_count; ++i) {
+            threads.emplace_back([this, i, &errors]{
+                try {
+                    runShard(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+
+        shards.clear();
+        curl_global_cleanup();
+        for (auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    inline const std::size_t shardCount() const noexcept {
+        return shard_count;
+    }
+
+    inline const std::size_t pendingUrlsQueueSize() {
+        auto guard = frontier->lock();
+        return frontier->getPendingUrlQueueSize();
+    }
+
+    inline const std::size_t visitedUrlsSize() {
+        auto guard = frontier->lock();
+        return frontier->getVisitedUrlSize();
+    }
+};
+
+#endif
\ No newline at end of file